@@ -514,7 +514,7 @@ void drawBitmaps200x200(T<GxEPD2_Type, page_height>& display)
   }
   //else
   {
-    bool mirror_y = (display.epd2.panel != GxEPD2::GDE0213B1);
+    bool mirror_y = true;
     display.clearScreen(); // use default for white
     int16_t x = (int16_t(display.epd2.WIDTH) - 200) / 2;
     int16_t y = (int16_t(display.epd2.HEIGHT) - 200) / 2;
@@ -524,7 +524,7 @@ void drawBitmaps200x200(T<GxEPD2_Type, page_height>& display)
       delay(2000);
     }
   }
-  bool mirror_y = (display.epd2.panel != GxEPD2::GDE0213B1);
+  bool mirror_y = true;
   for (uint16_t i = 0; i < sizeof(bitmaps) / sizeof(char*); i++)
   {
     int16_t x = -60;
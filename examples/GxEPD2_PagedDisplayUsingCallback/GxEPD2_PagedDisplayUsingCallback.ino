@@ -532,7 +532,7 @@ void drawBitmaps200x200()
   }
   //else
   {
-    bool mirror_y = (display.epd2.panel != GxEPD2::GDE0213B1);
+    bool mirror_y = true;
     display.clearScreen(); // use default for white
     uint16_t x = (display.epd2.WIDTH - 200) / 2;
     uint16_t y = (display.epd2.HEIGHT - 200) / 2;
@@ -542,7 +542,7 @@ void drawBitmaps200x200()
       delay(2000);
     }
   }
-  bool mirror_y = (display.epd2.panel != GxEPD2::GDE0213B1);
+  bool mirror_y = true;
   for (uint16_t i = 0; i < sizeof(bitmaps) / sizeof(char*); i++)
   {
     int16_t x = -60;
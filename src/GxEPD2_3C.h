@@ -14,6 +14,12 @@
 
 #include <Adafruit_GFX.h>
 #include "GxEPD2_EPD.h"
+#include "GxEPD2_RefreshPlanner.h"
+#include "GxEPD2_RefreshPolicy.h"
+#include "GxEPD2_GlyphCache.h"
+#if defined(ESP32)
+#include <freertos/semphr.h>
+#endif
 #include "epd3c/GxEPD2_154c.h"
 #include "epd3c/GxEPD2_213c.h"
 #include "epd3c/GxEPD2_290c.h"
@@ -31,7 +37,9 @@
 #include "GxEPD2_GFX.h"
 #endif
 
-template<typename GxEPD2_Type, const uint16_t page_height>
+// fixed_rotation 0..3 : rotation and mirror (fixed_mirror) are compile time constants, setRotation() and mirror() keep them
+// the pixel transform is then straight-line code; default -1 : runtime rotation and mirror
+template<typename GxEPD2_Type, const uint16_t page_height, const int8_t fixed_rotation = -1, const bool fixed_mirror = false>
 #if ENABLE_GxEPD2_GFX
 class GxEPD2_3C : public GxEPD2_GFX
 #else
@@ -40,43 +48,100 @@ class GxEPD2_3C : public Adafruit_GFX
 {
   public:
     GxEPD2_Type epd2;
+    static const uint8_t max_partial_windows = 4; // for setPartialWindows()
 #if ENABLE_GxEPD2_GFX
     GxEPD2_3C(GxEPD2_Type epd2_instance) : epd2(epd2_instance), GxEPD2_GFX(epd2, GxEPD2_Type::WIDTH, GxEPD2_Type::HEIGHT)
 #else
     GxEPD2_3C(GxEPD2_Type epd2_instance) : Adafruit_GFX(GxEPD2_Type::WIDTH, GxEPD2_Type::HEIGHT), epd2(epd2_instance)
 #endif
     {
-      _page_height = page_height;
-      _pages = (HEIGHT / _page_height) + ((HEIGHT % _page_height) > 0);
+      _ping_pong = false;
+      _setPageBuffer(0, 0);
       _using_partial_mode = false;
       _current_page = 0;
+      _resetDirty();
+      _policy = 0;
+      _glyph_cache = 0;
+      _background = 0;
+      _background_color = 0;
+      _background_callback = 0;
+      _color_hash = 0;
+#if defined(ESP32)
+      _writer = 0;
+      _write_request = 0;
+      _write_done = 0;
+#endif
+      _mirror = false;
+      setRotation(0); // fixed_rotation, if any
       setFullWindow();
     }
 
+    // page buffer provided by the application, e.g. in PSRAM, holds both planes; page height and number of pages follow from buffer_size
+    // the embedded buffer of page_height rows is used if buffer is NULL or too small for one row; use page_height 1 to keep it small
+#if ENABLE_GxEPD2_GFX
+    GxEPD2_3C(GxEPD2_Type epd2_instance, uint8_t* buffer, uint32_t buffer_size) : epd2(epd2_instance), GxEPD2_GFX(epd2, GxEPD2_Type::WIDTH, GxEPD2_Type::HEIGHT)
+#else
+    GxEPD2_3C(GxEPD2_Type epd2_instance, uint8_t* buffer, uint32_t buffer_size) : Adafruit_GFX(GxEPD2_Type::WIDTH, GxEPD2_Type::HEIGHT), epd2(epd2_instance)
+#endif
+    {
+      _ping_pong = false;
+      _setPageBuffer(buffer, buffer_size);
+      _using_partial_mode = false;
+      _current_page = 0;
+      _resetDirty();
+      _policy = 0;
+      _glyph_cache = 0;
+      _background = 0;
+      _background_color = 0;
+      _background_callback = 0;
+      _color_hash = 0;
+#if defined(ESP32)
+      _writer = 0;
+      _write_request = 0;
+      _write_done = 0;
+#endif
+      _mirror = false;
+      setRotation(0); // fixed_rotation, if any
+      setFullWindow();
+    }
+
+#if defined(ESP32)
+    ~GxEPD2_3C()
+    {
+      setPingPong(false); // stops the writer task
+    }
+#endif
+
     bool mirror(bool m)
     {
+      if (fixed_rotation >= 0) return fixed_mirror;
       swap (_mirror, m);
       return m;
     }
 
+    void setRotation(uint8_t r)
+    {
+      Adafruit_GFX::setRotation(fixed_rotation < 0 ? r : fixed_rotation);
+    }
+
     void drawPixel(int16_t x, int16_t y, uint16_t color)
     {
-      if ((x < 0) || (x >= width()) || (y < 0) || (y >= height())) return;
-      if (_mirror) x = width() - x - 1;
+      if ((x < 0) || (x >= _displayWidth()) || (y < 0) || (y >= _displayHeight())) return;
+      if (_mirrored()) x = _displayWidth() - x - 1;
       // check rotation, move pixel around if necessary
-      switch (getRotation())
+      switch (_rotation())
       {
         case 1:
           swap(x, y);
-          x = WIDTH - x - 1;
+          x = GxEPD2_Type::WIDTH - x - 1;
           break;
         case 2:
-          x = WIDTH - x - 1;
-          y = HEIGHT - y - 1;
+          x = GxEPD2_Type::WIDTH - x - 1;
+          y = GxEPD2_Type::HEIGHT - y - 1;
           break;
         case 3:
           swap(x, y);
-          y = HEIGHT - y - 1;
+          y = GxEPD2_Type::HEIGHT - y - 1;
           break;
       }
       // transpose partial window to 0,0
@@ -84,14 +149,17 @@ class GxEPD2_3C : public Adafruit_GFX
       y -= _pw_y;
       // adjust for current page
       y -= _current_page * _page_height;
-      // check if in current page
-      if ((y < 0) || (y >= _page_height)) return;
-      uint16_t i = x / 8 + y * (_pw_w / 8);
+      // check if in window and current page
+      if ((x < 0) || (x >= _pw_w) || (y < 0) || (y >= _page_height)) return;
+      uint32_t i = x / 8 + uint32_t(y) * (_pw_w / 8);
+      uint8_t black = _black_buffer[i];
+      uint8_t red = _color_buffer[i];
       _black_buffer[i] = (_black_buffer[i] | (1 << (7 - x % 8))); // white
       _color_buffer[i] = _color_buffer[i] = (_color_buffer[i] | (1 << (7 - x % 8)));
-      if (color == GxEPD_WHITE) return;
+      if (color == GxEPD_WHITE);
       else if (color == GxEPD_BLACK) _black_buffer[i] = (_black_buffer[i] & (0xFF ^ (1 << (7 - x % 8))));
       else if (color == GxEPD_RED) _color_buffer[i] = (_color_buffer[i] & (0xFF ^ (1 << (7 - x % 8))));
+      if ((_black_buffer[i] != black) || (_color_buffer[i] != red)) _setDirty(x, y, x, y);
     }
 
     void init(uint32_t serial_diag_bitrate = 0) // = 0 : disabled
@@ -99,6 +167,7 @@ class GxEPD2_3C : public Adafruit_GFX
       epd2.init(serial_diag_bitrate);
       _using_partial_mode = false;
       _current_page = 0;
+      _color_hash = 0;
       setFullWindow();
     }
 
@@ -109,18 +178,187 @@ class GxEPD2_3C : public Adafruit_GFX
       if (color == GxEPD_WHITE);
       else if (color == GxEPD_BLACK) black = 0x00;
       else if (color == GxEPD_RED) red = 0x00;
-      for (uint16_t x = 0; x < sizeof(_black_buffer); x++)
-      {
-        _black_buffer[x] = black;
-        _color_buffer[x] = red;
-      }
+      int32_t first = -1, last = -1; // changed bytes, of both planes
+      _ropSpan(_black_buffer, 0, _usedBytes(), black, GxEPD2::RopCopy, first, last);
+      int32_t color_first = -1, color_last = -1;
+      _ropSpan(_color_buffer, 0, _usedBytes(), red, GxEPD2::RopCopy, color_first, color_last);
+      if ((color_first >= 0) && ((first < 0) || (color_first < first))) first = color_first;
+      if (color_last > last) last = color_last;
+      if (first >= 0) _setDirtyBytes(first, last);
+    }
+
+    void drawFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color)
+    {
+      fillRect(x, y, w, 1, color);
+    }
+
+    void drawFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color)
+    {
+      fillRect(x, y, 1, h, color);
+    }
+
+    // clipped once, then written 32 bits at a time with masked edge bytes to both planes, any rotation
+    void fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color)
+    {
+      fillRectRop(x, y, w, h, color, GxEPD2::RopCopy);
+    }
+
+    // fill combined with the buffer content by op, GxEPD2::RopCopy, RopOr, RopAnd or RopXor
+    // bitwise on the pixel values of each plane, white is 1, black or color is 0 in its plane
+    void fillRectRop(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color, GxEPD2::RasterOp op)
+    {
+      uint16_t bx, by, bw, bh;
+      if (!_clipRect(x, y, w, h, bx, by, bw, bh)) return;
+      bool changed = _ropRect(_black_buffer, bx, by, bw, bh, color == GxEPD_BLACK ? 0x00 : 0xFF, op);
+      if (_ropRect(_color_buffer, bx, by, bw, bh, color == GxEPD_RED ? 0x00 : 0xFF, op)) changed = true;
+      if (changed) _setDirty(bx, by, bx + bw - 1, by + bh - 1);
+    }
+
+    // invert black and white, color pixels are kept; e.g. selection highlight or cursor blink, without drawing again
+    void invertRect(int16_t x, int16_t y, int16_t w, int16_t h)
+    {
+      uint16_t bx, by, bw, bh;
+      if (!_clipRect(x, y, w, h, bx, by, bw, bh)) return;
+      if (_ropRect(_black_buffer, bx, by, bw, bh, 0xFF, GxEPD2::RopXor)) _setDirty(bx, by, bx + bw - 1, by + bh - 1);
+    }
+
+    // masked sprite: pixels of set bitmap bits are combined with color by op, in each plane
+    void drawBitmapRop(int16_t x, int16_t y, const uint8_t bitmap[], int16_t w, int16_t h, uint16_t color, GxEPD2::RasterOp op, bool pgm = true)
+    {
+      _drawBitmap(bitmap, x, y, w, h, color, false, pgm, op);
     }
 
     // display buffer content to screen, useful for full screen buffer
+    // partial update with unchanged color content uses the B/W only refresh, if the panel has one
     void display(bool partial_update_mode = false)
     {
-      epd2.writeImage(_black_buffer, _color_buffer, 0, 0, WIDTH, HEIGHT);
-      epd2.refresh(partial_update_mode);
+      bool color_unchanged = _colorUnchanged();
+      bool full = !partial_update_mode || (_policy && _policy->partialRefresh(0, 0, WIDTH, HEIGHT)); // asked once
+      if (color_unchanged && !full)
+      {
+        epd2.drawImageBlackOnly(_black_buffer, _color_buffer, 0, 0, WIDTH, HEIGHT);
+      }
+      else
+      {
+        epd2.writeImage(_black_buffer, _color_buffer, 0, 0, WIDTH, HEIGHT);
+        _refreshAs(full);
+      }
+      _resetDirty();
+    }
+
+    // write and refresh only the byte aligned region changed since last display, for full screen buffer
+    // the changed buffer rows are written with window width, the refresh is limited to the region
+    void displayChanged()
+    {
+      if (!epd2.hasPartialUpdate) return display(false);
+      if (_dirty_x1 > _dirty_x2) return; // nothing changed
+      uint16_t x1 = _dirty_x1 - _dirty_x1 % 8;
+      uint16_t x2 = _dirty_x2 | 0x0007;
+      uint16_t y1 = _dirty_y1;
+      uint16_t y2 = gx_uint16_min(_dirty_y2, gx_uint16_min(_pw_h, _page_height) - 1);
+      if (y1 > y2) return;
+      uint16_t h = y2 - y1 + 1;
+      uint32_t offset = uint32_t(y1) * (_pw_w / 8);
+      bool color_unchanged = _colorUnchanged();
+      bool full = _policy && _policy->partialRefresh(_pw_x + x1, _pw_y + y1, x2 - x1 + 1, h); // asked once
+      if (color_unchanged && !full)
+      {
+        // B/W only refresh of the changed rows, window width
+        epd2.drawImageBlackOnly(_black_buffer + offset, _color_buffer + offset, _pw_x, _pw_y + y1, _pw_w, h);
+      }
+      else
+      {
+        epd2.writeImage(_black_buffer + offset, _color_buffer + offset, _pw_x, _pw_y + y1, _pw_w, h);
+        if (full) _refreshAs(true);
+        else epd2.refresh(_pw_x + x1, _pw_y + y1, x2 - x1 + 1, h);
+      }
+      _resetDirty();
+    }
+
+    // write and refresh regions (display coordinates) with the least estimated refresh time, for full screen buffer
+    // regions are refreshed separately, merged or replaced by a full refresh, see GxEPD2_RefreshPlanner
+    void displayRegions(const GxEPD2_Region regions[], uint8_t count)
+    {
+      GxEPD2_RefreshPlanner<GxEPD2_Type> planner;
+      for (uint8_t i = 0; i < count; i++)
+      {
+        uint16_t x = regions[i].x, y = regions[i].y, w = regions[i].w, h = regions[i].h;
+        // mirror, then rotate, as drawing does
+        if (_mirrored())
+        {
+          if (x + w > _displayWidth()) w = x < _displayWidth() ? _displayWidth() - x : 0;
+          x = _displayWidth() - x - w;
+        }
+        _rotate(x, y, w, h);
+        // limit to window and buffer
+        uint16_t x1 = gx_uint16_max(x, _pw_x);
+        uint16_t y1 = gx_uint16_max(y, _pw_y);
+        uint16_t x2 = gx_uint16_min(x + w, _pw_x + _pw_w);
+        uint16_t y2 = gx_uint16_min(y + h, _pw_y + gx_uint16_min(_pw_h, _page_height));
+        if ((x2 > x1) && (y2 > y1)) planner.add(x1, y1, x2 - x1, y2 - y1);
+      }
+      if (planner.plan(!_using_partial_mode) == 0) return;
+      if (planner.isFullRefresh() || !epd2.hasPartialUpdate) return display(false);
+      _color_hash = 0; // color outside the regions not refreshed
+      _writeRegionRows(planner);
+      _refresh(planner);
+      _resetDirty();
+    }
+
+    // attach policy for automatic full refresh after partial refreshes (ghosting); NULL detaches
+    void setRefreshPolicy(GxEPD2_RefreshPolicy* policy)
+    {
+      _policy = policy;
+      if (_policy) _policy->begin(WIDTH, HEIGHT);
+    }
+
+    // do a full refresh if the refresh policy has one pending, to be called when the screen is idle
+    bool idleRefresh()
+    {
+      if (!_policy || !_policy->fullRefreshPending()) return false;
+      _refresh(false);
+      return true;
+    }
+
+    // attach cache for GFXfont glyphs, text size 1 is then drawn by the byte-wise blitter; NULL detaches
+    void setGlyphCache(GxEPD2_GlyphCache* cache)
+    {
+      _glyph_cache = cache;
+    }
+
+    // ping-pong page buffers for paged drawing: the buffer is split in two pages, the finished page is written to the controller
+    // by a task on the other core while the next page is drawn; the picture loop and drawPaged() are used as before
+    // ESP32 only; returns false elsewhere, or if the buffer is too small for two pages of one row
+    bool setPingPong(bool enable)
+    {
+#if defined(ESP32)
+      if (enable == _ping_pong) return true;
+      if (enable)
+      {
+        if (_buffer_size / 2 < WIDTH / 8) return false;
+        _write_request = xSemaphoreCreateBinary();
+        _write_done = xSemaphoreCreateBinary();
+        if (_write_done) xSemaphoreGive(_write_done);
+        // the Arduino loop runs on core 1
+        if (!_write_request || !_write_done || (xTaskCreatePinnedToCore(_writeTask, "GxEPD2_write", 4096, this, 1, &_writer, 0) != pdPASS))
+        {
+          _writer = 0;
+          _deleteWriter();
+          return false;
+        }
+      }
+      else
+      {
+        _waitWrite();
+        _deleteWriter();
+      }
+      _ping_pong = enable;
+      _setPlanes(_buffer_base);
+      _planPages();
+      return true;
+#else
+      return !enable;
+#endif
     }
 
     void setFullWindow()
@@ -130,29 +368,87 @@ class GxEPD2_3C : public Adafruit_GFX
       _pw_y = 0;
       _pw_w = WIDTH;
       _pw_h = HEIGHT;
+      _planPages();
+      _color_hash = 0;
+      _setDirty(0, 0, _pw_w - 1, _pw_h - 1);
     }
 
     void setPartialWindow(uint16_t x, uint16_t y, uint16_t w, uint16_t h)
+    {
+      GxEPD2_Region region = {x, y, w, h};
+      setPartialWindows(&region, 1);
+    }
+
+    // several partial windows (display coordinates) updated by one picture loop or drawPaged(), up to max_partial_windows
+    // each window is drawn and written in turn, then all are refreshed with the least estimated time, see GxEPD2_RefreshPlanner
+    void setPartialWindows(const GxEPD2_Region regions[], uint8_t count)
     {
       if (!epd2.hasPartialUpdate) return;
-      _rotate(x, y, w, h);
+      if (count == 0) return;
       _using_partial_mode = true;
-      _pw_x = gx_uint16_min(x, WIDTH);
-      _pw_y = gx_uint16_min(y, HEIGHT);
-      _pw_w = gx_uint16_min(w, WIDTH - _pw_x);
-      _pw_h = gx_uint16_min(h, HEIGHT - _pw_y);
-      // make _pw_x, _pw_w multiple of 8
-      _pw_w += _pw_x % 8;
-      if (_pw_w % 8 > 0) _pw_w += 8 - _pw_w % 8;
-      _pw_x -= _pw_x % 8;
+      _window_count = count < max_partial_windows ? count : max_partial_windows;
+      for (uint8_t i = 0; i < _window_count; i++)
+      {
+        uint16_t x = regions[i].x, y = regions[i].y, w = regions[i].w, h = regions[i].h;
+        _rotate(x, y, w, h);
+        _pw_x = gx_uint16_min(x, WIDTH);
+        _pw_y = gx_uint16_min(y, HEIGHT);
+        _pw_w = gx_uint16_min(w, WIDTH - _pw_x);
+        _pw_h = gx_uint16_min(h, HEIGHT - _pw_y);
+        // make _pw_x, _pw_w multiple of 8
+        _pw_w += _pw_x % 8;
+        if (_pw_w % 8 > 0) _pw_w += 8 - _pw_w % 8;
+        _pw_x -= _pw_x % 8;
+        _windows[i].x = _pw_x;
+        _windows[i].y = _pw_y;
+        _windows[i].w = _pw_w;
+        _windows[i].h = _pw_h;
+      }
+      _selectWindow(0);
+      _color_hash = 0;
+      _setDirty(0, 0, _pw_w - 1, _pw_h - 1);
     }
 
-    void firstPage()
+    // static background layer, the picture loop or drawCallback draws only the dynamic overlay
+    // bitmaps in controller orientation and format, as for writeImage(), WIDTH x HEIGHT, NULL plane white; copied to each page
+    void setBackground(const uint8_t* black, const uint8_t* color, bool pgm = true)
+    {
+      _background = black;
+      _background_color = color;
+      _background_pgm = pgm;
+      _background_callback = 0;
+    }
+
+    // background drawn for each page by drawCallback, e.g. replay() of a GxEPD2_DisplayList or a decoder of compressed data
+    void setBackground(void (*drawCallback)(const void*), const void* pv)
+    {
+      _background = 0;
+      _background_color = 0;
+      _background_callback = drawCallback;
+      _background_pv = pv;
+    }
+
+    // clear the buffer (current page) to the background, white if none; called by firstPage(), nextPage() and drawPaged()
+    // for full screen buffer use instead of fillScreen() before drawing the overlay
+    void drawBackground()
     {
+      if (_background || _background_color)
+      {
+        _copyBackground(_black_buffer, _background);
+        _copyBackground(_color_buffer, _background_color);
+        return;
+      }
       fillScreen(GxEPD_WHITE);
+      if (_background_callback) _background_callback(_background_pv);
+    }
+
+    void firstPage()
+    {
       _current_page = 0;
       _second_phase = false;
+      _color_hash = 0; // paged drawing
       epd2.setPaged(); // for GxEPD2_154c paged workaround
+      drawBackground();
     }
 
     bool nextPage()
@@ -169,7 +465,7 @@ class GxEPD2_3C : public Adafruit_GFX
         {
           //Serial.print("writeImage("); Serial.print(_pw_x); Serial.print(", "); Serial.print(dest_ys); Serial.print(", ");
           //Serial.print(_pw_w); Serial.print(", "); Serial.print(dest_ye - dest_ys); Serial.println(")");
-          epd2.writeImage(_black_buffer, _color_buffer, _pw_x, dest_ys, _pw_w, dest_ye - dest_ys);
+          _writePage(_pw_x, dest_ys, _pw_w, dest_ye - dest_ys);
         }
         else
         {
@@ -181,42 +477,56 @@ class GxEPD2_3C : public Adafruit_GFX
         if (_current_page == _pages)
         {
           _current_page = 0;
+          if (_current_window + 1 < _window_count)
+          {
+            _selectWindow(_current_window + 1);
+            _swapPageBuffer();
+            drawBackground();
+            return true;
+          }
+          _waitWrite();
+          _selectWindow(0);
           if (!_second_phase)
           {
-            epd2.refresh(_pw_x, _pw_y, _pw_w, _pw_h);
+            _refreshWindows();
             if (epd2.hasFastPartialUpdate)
             {
               _second_phase = true;
               return true;
             }
           }
+          _resetDirty();
           return false;
         }
-        fillScreen(GxEPD_WHITE);
+        _swapPageBuffer();
+        drawBackground();
         return true;
       }
       else
       {
-        epd2.writeImage(_black_buffer, _color_buffer, 0, page_ys, WIDTH, gx_uint16_min(_page_height, HEIGHT - page_ys));
+        _writePage(0, page_ys, WIDTH, gx_uint16_min(_page_height, HEIGHT - page_ys));
         _current_page++;
         if (_current_page == _pages)
         {
           _current_page = 0;
+          _waitWrite();
           if (epd2.panel == GxEPD2::GDEW0154Z04)
           {
             if (!_second_phase)
             {
-              epd2.refresh(false);
+              _refresh(false);
               _second_phase = true;
-              fillScreen(GxEPD_WHITE);
+              drawBackground();
               return true;
             }
             else epd2.refresh(true);
-          } else epd2.refresh(false);
+          } else _refresh(false);
           epd2.powerOff();
+          _resetDirty();
           return false;
         }
-        fillScreen(GxEPD_WHITE);
+        _swapPageBuffer();
+        drawBackground();
         return true;
       }
     }
@@ -226,20 +536,27 @@ class GxEPD2_3C : public Adafruit_GFX
     {
       if (_using_partial_mode)
       {
-        for (_current_page = 0; _current_page < _pages; _current_page++)
+        for (uint8_t window = 0; window < _window_count; window++)
         {
-          uint16_t page_ys = _current_page * _page_height;
-          uint16_t page_ye = _current_page < (_pages - 1) ? page_ys + _page_height : HEIGHT;
-          uint16_t dest_ys = _pw_y + page_ys; // transposed
-          uint16_t dest_ye = gx_uint16_min(_pw_y + _pw_h, _pw_y + page_ye);
-          if (dest_ye > dest_ys)
+          _selectWindow(window);
+          for (_current_page = 0; _current_page < _pages; _current_page++)
           {
-            fillScreen(GxEPD_WHITE);
-            drawCallback(pv);
-            epd2.writeImage(_black_buffer, _color_buffer, _pw_x, dest_ys, _pw_w, dest_ye - dest_ys);
+            uint16_t page_ys = _current_page * _page_height;
+            uint16_t page_ye = _current_page < (_pages - 1) ? page_ys + _page_height : HEIGHT;
+            uint16_t dest_ys = _pw_y + page_ys; // transposed
+            uint16_t dest_ye = gx_uint16_min(_pw_y + _pw_h, _pw_y + page_ye);
+            if (dest_ye > dest_ys)
+            {
+              _swapPageBuffer();
+              drawBackground();
+              drawCallback(pv);
+              _writePage(_pw_x, dest_ys, _pw_w, dest_ye - dest_ys);
+            }
           }
         }
-        epd2.refresh(_pw_x, _pw_y, _pw_w, _pw_h);
+        _waitWrite();
+        _selectWindow(0);
+        _refreshWindows();
       }
       else
       {
@@ -247,95 +564,177 @@ class GxEPD2_3C : public Adafruit_GFX
         for (_current_page = 0; _current_page < _pages; _current_page++)
         {
           uint16_t page_ys = _current_page * _page_height;
-          fillScreen(GxEPD_WHITE);
+          _swapPageBuffer();
+          drawBackground();
           drawCallback(pv);
-          epd2.writeImage(_black_buffer, _color_buffer, 0, page_ys, WIDTH, gx_uint16_min(_page_height, HEIGHT - page_ys));
+          _writePage(0, page_ys, WIDTH, gx_uint16_min(_page_height, HEIGHT - page_ys));
         }
         if (epd2.panel == GxEPD2::GDEW0154Z04)
         { // GxEPD2_154c paged workaround: write color part
           for (_current_page = 0; _current_page < _pages; _current_page++)
           {
             uint16_t page_ys = _current_page * _page_height;
-            fillScreen(GxEPD_WHITE);
+            _swapPageBuffer();
+            drawBackground();
             drawCallback(pv);
-            epd2.writeImage(_black_buffer, _color_buffer, 0, page_ys, WIDTH, gx_uint16_min(_page_height, HEIGHT - page_ys));
+            _writePage(0, page_ys, WIDTH, gx_uint16_min(_page_height, HEIGHT - page_ys));
           }
         }
-        epd2.refresh();
+        _waitWrite();
+        _refresh(false);
       }
       _current_page = 0;
+      _resetDirty();
     }
 
     void drawInvertedBitmap(int16_t x, int16_t y, const uint8_t bitmap[], int16_t w, int16_t h, uint16_t color)
     {
-      // taken from Adafruit_GFX.cpp, modified
-      int16_t byteWidth = (w + 7) / 8; // Bitmap scanline pad = whole byte
-      uint8_t byte = 0;
-      for (int16_t j = 0; j < h; j++)
+      _drawBitmap(bitmap, x, y, w, h, color, true, true);
+    }
+
+    // Adafruit_GFX drawBitmap variants, bitmap in program memory or in RAM, through the byte-wise blitter
+    void drawBitmap(int16_t x, int16_t y, const uint8_t bitmap[], int16_t w, int16_t h, uint16_t color)
+    {
+      _drawBitmap(bitmap, x, y, w, h, color, false, true);
+    }
+
+    void drawBitmap(int16_t x, int16_t y, const uint8_t bitmap[], int16_t w, int16_t h, uint16_t color, uint16_t bg)
+    {
+      _drawBitmap(bitmap, x, y, w, h, color, false, true);
+      _drawBitmap(bitmap, x, y, w, h, bg, true, true);
+    }
+
+    void drawBitmap(int16_t x, int16_t y, uint8_t* bitmap, int16_t w, int16_t h, uint16_t color)
+    {
+      _drawBitmap(bitmap, x, y, w, h, color, false, false);
+    }
+
+    void drawBitmap(int16_t x, int16_t y, uint8_t* bitmap, int16_t w, int16_t h, uint16_t color, uint16_t bg)
+    {
+      _drawBitmap(bitmap, x, y, w, h, color, false, false);
+      _drawBitmap(bitmap, x, y, w, h, bg, true, false);
+    }
+
+    // current page in display coordinates (rotation and mirror applied), for culling in paged drawing
+    void getPageBounds(int16_t& x, int16_t& y, int16_t& w, int16_t& h)
+    {
+      uint16_t bx = _pw_x;
+      uint16_t by = _pw_y + _current_page * _page_height;
+      uint16_t bw = _pw_w;
+      uint16_t bh = by < _pw_y + _pw_h ? gx_uint16_min(_page_height, _pw_y + _pw_h - by) : 0;
+      switch (_rotation())
       {
-        for (int16_t i = 0; i < w; i++ )
-        {
-          if (i & 7) byte <<= 1;
-          else
-          {
-#if defined(__AVR) || defined(ESP8266) || defined(ESP32)
-            byte = pgm_read_byte(&bitmap[j * byteWidth + i / 8]);
-#else
-            byte = bitmap[j * byteWidth + i / 8];
-#endif
-          }
-          if (!(byte & 0x80))
-          {
-            drawPixel(x + i, y + j, color);
-          }
-        }
+        case 1:
+          x = by;
+          y = WIDTH - bx - bw;
+          w = bh;
+          h = bw;
+          break;
+        case 2:
+          x = WIDTH - bx - bw;
+          y = HEIGHT - by - bh;
+          w = bw;
+          h = bh;
+          break;
+        case 3:
+          x = HEIGHT - by - bh;
+          y = bx;
+          w = bh;
+          h = bw;
+          break;
+        default:
+          x = bx;
+          y = by;
+          w = bw;
+          h = bh;
+      }
+      if (_mirrored()) x = _displayWidth() - x - w;
+    }
+
+    // false if rectangle x, y, w, h (display coordinates) misses the current page, nothing to draw
+    bool intersectsPage(int16_t x, int16_t y, int16_t w, int16_t h)
+    {
+      int16_t px, py, pw, ph;
+      getPageBounds(px, py, pw, ph);
+      return (x < px + pw) && (px < int32_t(x) + w) && (y < py + ph) && (py < int32_t(y) + h);
+    }
+
+    // lines missing the current page are skipped
+    void drawLine(int16_t x0, int16_t y0, int16_t x1, int16_t y1, uint16_t color)
+    {
+      int16_t x = x0 < x1 ? x0 : x1;
+      int16_t y = y0 < y1 ? y0 : y1;
+      if (!intersectsPage(x, y, abs(x1 - x0) + 1, abs(y1 - y0) + 1)) return;
+      Adafruit_GFX::drawLine(x0, y0, x1, y1, color);
+    }
+
+    // text glyphs missing the current page only advance the cursor
+    size_t write(uint8_t c)
+    {
+      GxEPD2_GlyphCache::Placement p;
+      if (!GxEPD2_GlyphCache::place(*this, gfxFont, c, p)) return Adafruit_GFX::write(c);
+      if (intersectsPage(p.x, p.y, p.w, p.h))
+      {
+        const uint8_t* glyph = _glyph_cache && gfxFont && p.size1 ? _glyph_cache->get(gfxFont, c) : 0;
+        if (!glyph) return Adafruit_GFX::write(c);
+        _drawBitmap(glyph, p.x, p.y, p.w, p.h, textcolor, false, false);
       }
+      setCursor(p.cursor_x, p.cursor_y);
+      return 1;
     }
 
     //  Support for Bitmaps (Sprites) to Controller Buffer and to Screen
     void clearScreen(uint8_t value = 0xFF) // init controller memory and screen (default white)
     {
       epd2.clearScreen(value);
+      _color_hash = 0;
     }
     void writeScreenBuffer(uint8_t value = 0xFF) // init controller memory (default white)
     {
       epd2.writeScreenBuffer(value);
+      _color_hash = 0;
     }
     // write to controller memory, without screen refresh; x and w should be multiple of 8
     void writeImage(const uint8_t bitmap[], int16_t x, int16_t y, int16_t w, int16_t h, bool invert = false, bool mirror_y = false, bool pgm = false)
     {
       epd2.writeImage(bitmap, x, y, w, h, invert, mirror_y, pgm);
+      _color_hash = 0;
     }
     void writeImage(const uint8_t* black, const uint8_t* color, int16_t x, int16_t y, int16_t w, int16_t h, bool invert = false, bool mirror_y = false, bool pgm = false)
     {
       epd2.writeImage(black, color, x, y, w, h, invert, mirror_y, pgm);
+      _color_hash = 0;
     }
     // write sprite of native data to controller memory, without screen refresh; x and w should be multiple of 8
     void writeNative(const uint8_t* data1, const uint8_t* data2, int16_t x, int16_t y, int16_t w, int16_t h, bool invert, bool mirror_y, bool pgm)
     {
       epd2.writeNative(data1, data2, x, y, w, h, invert, mirror_y, pgm);
+      _color_hash = 0;
     }
     // write to controller memory, with screen refresh; x and w should be multiple of 8
     void drawImage(const uint8_t bitmap[], int16_t x, int16_t y, int16_t w, int16_t h, bool invert = false, bool mirror_y = false, bool pgm = false)
     {
       epd2.drawImage(bitmap, x, y, w, h, invert, mirror_y, pgm);
+      _color_hash = 0;
     }
     void drawImage(const uint8_t* black, const uint8_t* color, int16_t x, int16_t y, int16_t w, int16_t h, bool invert = false, bool mirror_y = false, bool pgm = false)
     {
       epd2.drawImage(black, color, x, y, w, h, invert, mirror_y, pgm);
+      _color_hash = 0;
     }
     // write sprite of native data to controller memory, with screen refresh; x and w should be multiple of 8
     void drawNative(const uint8_t* data1, const uint8_t* data2, int16_t x, int16_t y, int16_t w, int16_t h, bool invert, bool mirror_y, bool pgm)
     {
       epd2.drawNative(data1, data2, x, y, w, h, invert, mirror_y, pgm);
+      _color_hash = 0;
     }
     void refresh(bool partial_update_mode = false) // screen refresh from controller memory to full screen
     {
-      epd2.refresh(partial_update_mode);
+      _refresh(partial_update_mode);
     }
     void refresh(int16_t x, int16_t y, int16_t w, int16_t h) // screen refresh from controller memory, partial screen
     {
-      epd2.refresh(x, y, w, h);
+      _refresh(x, y, w, h);
     }
     void powerOff()
     {
@@ -357,9 +756,60 @@ class GxEPD2_3C : public Adafruit_GFX
     {
       return (a > b ? a : b);
     };
+    void _setPageBuffer(uint8_t* buffer, uint32_t buffer_size)
+    {
+      uint32_t rows = buffer ? buffer_size / (2 * (GxEPD2_Type::WIDTH / 8)) : 0;
+      if (rows == 0)
+      {
+        buffer = _page_buffer;
+        rows = page_height;
+      }
+      _page_height = rows < uint32_t(GxEPD2_Type::HEIGHT) ? rows : GxEPD2_Type::HEIGHT;
+      _pages = (HEIGHT / _page_height) + ((HEIGHT % _page_height) > 0);
+      _buffer_size = uint32_t(GxEPD2_Type::WIDTH / 8) * _page_height;
+      _buffer_base = buffer;
+      _setPlanes(buffer);
+    }
+    // with ping-pong buffers each page holds both planes in half of the buffer
+    void _setPlanes(uint8_t* black)
+    {
+      _black_buffer = black;
+      _color_buffer = black + (_ping_pong ? _buffer_size / 2 : _buffer_size);
+    }
+    // page height and number of pages for the current window; a narrow partial window uses the whole buffer for taller pages
+    void _planPages()
+    {
+      uint16_t wb = gx_uint16_max(_pw_w / 8, 1);
+      uint16_t h = gx_uint16_max(_pw_h, 1);
+      uint32_t rows = (_ping_pong ? _buffer_size / 2 : _buffer_size) / wb;
+      _page_height = rows < h ? rows : h;
+      _pages = (h / _page_height) + ((h % _page_height) > 0);
+    }
+    // buffer bytes of a page of the current window
+    uint32_t _usedBytes()
+    {
+      return uint32_t(_page_height) * (_pw_w / 8);
+    }
+    // constants for a fixed rotation, folded by the compiler
+    uint8_t _rotation()
+    {
+      return fixed_rotation < 0 ? getRotation() : fixed_rotation;
+    }
+    bool _mirrored()
+    {
+      return fixed_rotation < 0 ? _mirror : fixed_mirror;
+    }
+    int16_t _displayWidth()
+    {
+      return fixed_rotation < 0 ? width() : (fixed_rotation & 1 ? int16_t(GxEPD2_Type::HEIGHT) : int16_t(GxEPD2_Type::WIDTH));
+    }
+    int16_t _displayHeight()
+    {
+      return fixed_rotation < 0 ? height() : (fixed_rotation & 1 ? int16_t(GxEPD2_Type::WIDTH) : int16_t(GxEPD2_Type::HEIGHT));
+    }
     void _rotate(uint16_t& x, uint16_t& y, uint16_t& w, uint16_t& h)
     {
-      switch (getRotation())
+      switch (_rotation())
       {
         case 1:
           swap(x, y);
@@ -377,14 +827,470 @@ class GxEPD2_3C : public Adafruit_GFX
           break;
       }
     }
+    // display rectangle to buffer rectangle of the current page, clipped; false if empty
+    bool _clipRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t& bx, uint16_t& by, uint16_t& bw, uint16_t& bh)
+    {
+      if (w < 0)
+      {
+        x += w + 1;
+        w = -w;
+      }
+      if (h < 0)
+      {
+        y += h + 1;
+        h = -h;
+      }
+      int32_t x1 = x < 0 ? 0 : x;
+      int32_t y1 = y < 0 ? 0 : y;
+      int32_t x2 = int32_t(x) + w < _displayWidth() ? int32_t(x) + w : _displayWidth(); // exclusive
+      int32_t y2 = int32_t(y) + h < _displayHeight() ? int32_t(y) + h : _displayHeight(); // exclusive
+      if ((x2 <= x1) || (y2 <= y1)) return false;
+      if (_mirrored())
+      {
+        int32_t t = x1;
+        x1 = _displayWidth() - x2;
+        x2 = _displayWidth() - t;
+      }
+      uint16_t rx = x1, ry = y1, rw = x2 - x1, rh = y2 - y1;
+      _rotate(rx, ry, rw, rh);
+      // transpose partial window to 0,0 and adjust for current page
+      x1 = int32_t(rx) - _pw_x;
+      y1 = int32_t(ry) - _pw_y - int32_t(_current_page) * _page_height;
+      x2 = x1 + rw;
+      y2 = y1 + rh;
+      if (x1 < 0) x1 = 0;
+      if (y1 < 0) y1 = 0;
+      if (x2 > _pw_w) x2 = _pw_w;
+      if (y2 > _page_height) y2 = _page_height;
+      if ((x2 <= x1) || (y2 <= y1)) return false;
+      bx = x1;
+      by = y1;
+      bw = x2 - x1;
+      bh = y2 - y1;
+      return true;
+    }
+    // combine buffer rectangle with value by op (GxEPD2::RasterOp), edge bytes masked; returns true if content changed
+    bool _ropRect(uint8_t* buffer, uint16_t x, uint16_t y, uint16_t w, uint16_t h, uint8_t value, uint8_t op)
+    {
+      uint16_t wb = _pw_w / 8;
+      int32_t first = -1, last = -1; // changed bytes
+      if ((x == 0) && (w == _pw_w))
+      {
+        // full rows are contiguous
+        _ropSpan(buffer, uint32_t(y) * wb, uint32_t(h) * wb, value, op, first, last);
+        return first >= 0;
+      }
+      uint16_t xb1 = x / 8;
+      uint16_t xb2 = (x + w - 1) / 8;
+      uint8_t mask1 = 0xFF >> (x % 8);
+      uint8_t mask2 = 0xFF << (7 - (x + w - 1) % 8);
+      if (xb1 == xb2) mask1 &= mask2;
+      for (uint16_t i = y; i < y + h; i++)
+      {
+        uint32_t row = uint32_t(i) * wb;
+        _ropByte(buffer, row + xb1, value, mask1, op, first, last);
+        if (xb2 == xb1) continue;
+        _ropSpan(buffer, row + xb1 + 1, xb2 - xb1 - 1, value, op, first, last);
+        _ropByte(buffer, row + xb2, value, mask2, op, first, last);
+      }
+      return first >= 0;
+    }
+    // combine n buffer bytes from start with value, 32 bits at a time where aligned; changed bytes extend first, last
+    static void _ropSpan(uint8_t* buffer, uint32_t start, uint32_t n, uint8_t value, uint8_t op, int32_t& first, int32_t& last)
+    {
+      uint32_t i = start;
+      uint32_t end = start + n;
+      for (; (i < end) && (uintptr_t(buffer + i) % 4 != 0); i++) _ropByte(buffer, i, value, 0xFF, op, first, last);
+      uint32_t value32 = value * 0x01010101UL;
+      for (; i + 4 <= end; i += 4)
+      {
+        uint32_t data, result;
+        memcpy(&data, buffer + i, 4);
+        switch (op)
+        {
+          case GxEPD2::RopOr: result = data | value32; break;
+          case GxEPD2::RopAnd: result = data & value32; break;
+          case GxEPD2::RopXor: result = data ^ value32; break;
+          default: result = value32;
+        }
+        if (result == data) continue;
+        memcpy(buffer + i, &result, 4);
+        if (first < 0) first = i;
+        last = i + 3;
+      }
+      for (; i < end; i++) _ropByte(buffer, i, value, 0xFF, op, first, last);
+    }
+    static void _ropByte(uint8_t* buffer, uint32_t i, uint8_t value, uint8_t mask, uint8_t op, int32_t& first, int32_t& last)
+    {
+      uint8_t data = buffer[i];
+      uint8_t result = (data & ~mask) | (_rop(data, value, op) & mask);
+      if (result == data) return;
+      buffer[i] = result;
+      if (first < 0) first = i;
+      last = i;
+    }
+    static uint8_t _rop(uint8_t data, uint8_t value, uint8_t op)
+    {
+      switch (op)
+      {
+        case GxEPD2::RopOr: return data | value;
+        case GxEPD2::RopAnd: return data & value;
+        case GxEPD2::RopXor: return data ^ value;
+      }
+      return value;
+    }
+    // buffer position of display pixel x, y, not clipped
+    void _bufferPosition(int16_t x, int16_t y, int32_t& bx, int32_t& by)
+    {
+      int32_t dx = _mirrored() ? _displayWidth() - x - 1 : x;
+      int32_t dy = y;
+      switch (_rotation())
+      {
+        case 1:
+          bx = WIDTH - dy - 1;
+          by = dx;
+          break;
+        case 2:
+          bx = WIDTH - dx - 1;
+          by = HEIGHT - dy - 1;
+          break;
+        case 3:
+          bx = dy;
+          by = HEIGHT - dx - 1;
+          break;
+        default:
+          bx = dx;
+          by = dy;
+      }
+      bx -= _pw_x;
+      by -= _pw_y + int32_t(_current_page) * _page_height;
+    }
+    // draw pixels of set bits (invert: clear bits) with color combined by op; clipped once, then shifted and masked into the buffer bytewise
+    void _drawBitmap(const uint8_t* bitmap, int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color, bool invert, bool pgm, uint8_t op = GxEPD2::RopCopy)
+    {
+      uint16_t bx, by, bw, bh;
+      if ((w <= 0) || (h <= 0) || !_clipRect(x, y, w, h, bx, by, bw, bh)) return;
+      // buffer position of bitmap pixel i, j is o + i * u + j * v
+      int32_t ox, oy, ux, uy, vx, vy;
+      _bufferPosition(x, y, ox, oy);
+      _bufferPosition(x + 1, y, ux, uy);
+      _bufferPosition(x, y + 1, vx, vy);
+      ux -= ox;
+      uy -= oy;
+      vx -= ox;
+      vy -= oy;
+      uint16_t wb = (w + 7) / 8; // bitmap scanline pad = whole byte
+      uint16_t dwb = _pw_w / 8;
+      uint8_t flip = invert ? 0xFF : 0x00;
+      uint8_t black = color == GxEPD_BLACK ? 0x00 : 0xFF;
+      uint8_t red = color == GxEPD_RED ? 0x00 : 0xFF;
+      bool changed = false;
+      for (uint16_t row = by; row < by + bh; row++)
+      {
+        for (uint16_t k = bx / 8; k <= (bx + bw - 1) / 8; k++)
+        {
+          uint16_t x1 = gx_uint16_max(k * 8, bx);
+          uint16_t x2 = gx_uint16_min(k * 8 + 8, bx + bw);
+          uint8_t mask = (0xFF >> (x1 - k * 8)) & (0xFF << (k * 8 + 8 - x2));
+          uint8_t bits = 0;
+          if (ux != 0)
+          {
+            // bitmap row to buffer row, forward or mirrored
+            const uint8_t* src = bitmap + uint32_t((int32_t(row) - oy) / vy) * wb;
+            int32_t i = (int32_t(k) * 8 - ox) * ux; // bitmap pixel of the first buffer pixel of this byte
+            if (ux > 0) bits = _bitmapBits(src, i, wb, pgm);
+            else bits = _reverseBits(_bitmapBits(src, i - 7, wb, pgm));
+          }
+          else
+          {
+            // bitmap column to buffer row, rotation 1 and 3
+            int32_t i = (int32_t(row) - oy) / uy;
+            for (uint16_t p = x1; p < x2; p++)
+            {
+              uint32_t j = (int32_t(p) - ox) / vx;
+              if (_bitmapByte(bitmap, j * wb + i / 8, pgm) & (0x80 >> (i % 8))) bits |= 0x80 >> (p % 8);
+            }
+          }
+          mask &= bits ^ flip;
+          if (!mask) continue;
+          uint32_t n = uint32_t(row) * dwb + k;
+          uint8_t black_data = (_black_buffer[n] & ~mask) | (_rop(_black_buffer[n], black, op) & mask);
+          uint8_t color_data = (_color_buffer[n] & ~mask) | (_rop(_color_buffer[n], red, op) & mask);
+          if ((black_data == _black_buffer[n]) && (color_data == _color_buffer[n])) continue;
+          _black_buffer[n] = black_data;
+          _color_buffer[n] = color_data;
+          changed = true;
+        }
+      }
+      if (changed) _setDirty(bx, by, bx + bw - 1, by + bh - 1);
+    }
+    // copy controller rows of the current page from a WIDTH x HEIGHT bitmap (NULL: white), white outside window
+    void _copyBackground(uint8_t* buffer, const uint8_t* bitmap)
+    {
+      uint16_t wb = _pw_w / 8;
+      uint16_t ys = _pw_y + _current_page * _page_height;
+      int32_t first = -1, last = -1; // changed bytes
+      for (uint16_t i = 0; i < _page_height; i++)
+      {
+        bool inside = bitmap && (ys + i < _pw_y + _pw_h);
+        uint32_t src = uint32_t(ys + i) * (WIDTH / 8) + _pw_x / 8;
+        for (uint16_t j = 0; j < wb; j++)
+        {
+          uint32_t n = uint32_t(i) * wb + j;
+          uint8_t data = inside ? _bitmapByte(bitmap, src + j, _background_pgm) : 0xFF;
+          if (buffer[n] == data) continue;
+          buffer[n] = data;
+          if (first < 0) first = n;
+          last = n;
+        }
+      }
+      if (first >= 0) _setDirtyBytes(first, last);
+    }
+    static uint8_t _bitmapByte(const uint8_t* bitmap, uint32_t idx, bool pgm)
+    {
+#if defined(__AVR) || defined(ESP8266) || defined(ESP32)
+      if (pgm) return pgm_read_byte(&bitmap[idx]);
+#endif
+      return bitmap[idx];
+    }
+    // 8 bits of a bitmap scanline starting at pixel i, i >= -7; pixels outside the scanline read as 0
+    static uint8_t _bitmapBits(const uint8_t* row, int32_t i, uint16_t wb, bool pgm)
+    {
+      int32_t b = (i + 8) / 8 - 1;
+      uint8_t shift = (i + 8) % 8;
+      uint8_t b0 = (b >= 0) && (b < wb) ? _bitmapByte(row, b, pgm) : 0;
+      if (shift == 0) return b0; // byte aligned
+      uint8_t b1 = (b + 1 >= 0) && (b + 1 < wb) ? _bitmapByte(row, b + 1, pgm) : 0;
+      return (b0 << shift) | (b1 >> (8 - shift));
+    }
+    static uint8_t _reverseBits(uint8_t b)
+    {
+      b = ((b & 0xF0) >> 4) | ((b & 0x0F) << 4);
+      b = ((b & 0xCC) >> 2) | ((b & 0x33) << 2);
+      return ((b & 0xAA) >> 1) | ((b & 0x55) << 1);
+    }
+    // write buffer rows of window width for controller rows ys to ye inclusive
+    void _writeRows(uint16_t ys, uint16_t ye)
+    {
+      uint32_t offset = uint32_t(ys - _pw_y) * (_pw_w / 8);
+      epd2.writeImage(_black_buffer + offset, _color_buffer + offset, _pw_x, ys, _pw_w, ye - ys + 1);
+    }
+    // write the union of the buffer rows of the planned regions
+    void _writeRegionRows(GxEPD2_RefreshPlanner<GxEPD2_Type>& planner)
+    {
+      uint16_t ys = 0; // next row not yet written
+      while (true)
+      {
+        // lowest region start at or after ys, extended by all regions overlapping the run
+        int32_t run_ys = -1, run_ye = -1;
+        for (uint8_t i = 0; i < planner.regions(); i++)
+        {
+          const GxEPD2_Region& r = planner.region(i);
+          if (r.y + r.h <= ys) continue;
+          uint16_t s = gx_uint16_max(r.y, ys);
+          if ((run_ys < 0) || (s < run_ys)) run_ys = s;
+        }
+        if (run_ys < 0) break;
+        run_ye = run_ys;
+        for (bool extended = true; extended;)
+        {
+          extended = false;
+          for (uint8_t i = 0; i < planner.regions(); i++)
+          {
+            const GxEPD2_Region& r = planner.region(i);
+            if ((r.y <= run_ye + 1) && (r.y + r.h - 1 > run_ye))
+            {
+              run_ye = r.y + r.h - 1;
+              extended = true;
+            }
+          }
+        }
+        _writeRows(run_ys, run_ye);
+        ys = run_ye + 1;
+      }
+    }
+    // screen refresh through the refresh policy, if attached
+    // write the current page; with ping-pong buffers the writer task does it, after the previous page is written
+    void _writePage(uint16_t x, uint16_t y, uint16_t w, uint16_t h)
+    {
+#if defined(ESP32)
+      if (_ping_pong)
+      {
+        xSemaphoreTake(_write_done, portMAX_DELAY);
+        _write_job.black = _black_buffer;
+        _write_job.color = _color_buffer;
+        _write_job.x = x;
+        _write_job.y = y;
+        _write_job.w = w;
+        _write_job.h = h;
+        xSemaphoreGive(_write_request);
+        return;
+      }
+#endif
+      epd2.writeImage(_black_buffer, _color_buffer, x, y, w, h);
+    }
+    // wait until the last page is written, before other controller access
+    void _waitWrite()
+    {
+#if defined(ESP32)
+      if (!_ping_pong) return;
+      xSemaphoreTake(_write_done, portMAX_DELAY);
+      xSemaphoreGive(_write_done);
+#endif
+    }
+    // draw the next page into the other buffer; it is free, its write was waited for by _writePage()
+    void _swapPageBuffer()
+    {
+      if (!_ping_pong) return;
+      _setPlanes(_black_buffer == _buffer_base ? _buffer_base + _buffer_size : _buffer_base);
+    }
+#if defined(ESP32)
+    // the writer task and its semaphores exist while ping-pong buffers are enabled
+    void _deleteWriter()
+    {
+      if (_writer) vTaskDelete(_writer);
+      if (_write_request) vSemaphoreDelete(_write_request);
+      if (_write_done) vSemaphoreDelete(_write_done);
+      _writer = 0;
+      _write_request = 0;
+      _write_done = 0;
+    }
+    static void _writeTask(void* pv)
+    {
+      GxEPD2_3C* display = (GxEPD2_3C*)pv;
+      SemaphoreHandle_t request = display->_write_request, done = display->_write_done; // set before the task is created
+      for (;;)
+      {
+        xSemaphoreTake(request, portMAX_DELAY);
+        WriteJob& job = display->_write_job;
+        display->epd2.writeImage(job.black, job.color, job.x, job.y, job.w, job.h);
+        xSemaphoreGive(done);
+      }
+    }
+#endif
+    void _refresh(bool partial_update_mode)
+    {
+      _refreshAs(!partial_update_mode || (_policy && _policy->partialRefresh(0, 0, WIDTH, HEIGHT)));
+    }
+    // full or partial refresh of the screen, the refresh policy already asked
+    void _refreshAs(bool full)
+    {
+      if (!full) epd2.refresh(true);
+      else
+      {
+        epd2.refresh(false);
+        if (_policy) _policy->fullRefresh();
+      }
+    }
+    void _refresh(int16_t x, int16_t y, int16_t w, int16_t h)
+    {
+      if (_policy && _policy->partialRefresh(x, y, w, h)) _refresh(false);
+      else epd2.refresh(x, y, w, h);
+    }
+    void _refresh(GxEPD2_RefreshPlanner<GxEPD2_Type>& planner)
+    {
+      if (planner.isFullRefresh()) _refresh(false);
+      else
+      {
+        for (uint8_t i = 0; i < planner.regions(); i++)
+        {
+          const GxEPD2_Region& r = planner.region(i);
+          _refresh(r.x, r.y, r.w, r.h);
+        }
+      }
+    }
+    // partial windows, separate or merged refreshes, whichever is estimated faster
+    void _refreshWindows()
+    {
+      if (_window_count == 1) _refresh(_pw_x, _pw_y, _pw_w, _pw_h);
+      else
+      {
+        GxEPD2_RefreshPlanner<GxEPD2_Type> planner;
+        for (uint8_t i = 0; i < _window_count; i++)
+        {
+          planner.add(_windows[i].x, _windows[i].y, _windows[i].w, _windows[i].h);
+        }
+        planner.plan(false);
+        _refresh(planner);
+      }
+    }
+    void _selectWindow(uint8_t i)
+    {
+      _current_window = i;
+      _pw_x = _windows[i].x;
+      _pw_y = _windows[i].y;
+      _pw_w = _windows[i].w;
+      _pw_h = _windows[i].h;
+      _planPages();
+    }
+    // color buffer compared with the one of the last refresh by display() or displayChanged(), hash 0 : unknown
+    bool _colorUnchanged()
+    {
+      if (!epd2.hasBlackOnlyRefresh) return false;
+      uint32_t hash = 2166136261UL; // FNV-1a
+      for (uint32_t i = 0; i < _usedBytes(); i++)
+      {
+        hash = (hash ^ _color_buffer[i]) * 16777619UL;
+      }
+      if (!hash) hash = 1;
+      bool unchanged = (hash == _color_hash);
+      _color_hash = hash;
+      return unchanged;
+    }
+    void _setDirty(uint16_t x1, uint16_t y1, uint16_t x2, uint16_t y2)
+    {
+      if (x1 < _dirty_x1) _dirty_x1 = x1;
+      if (y1 < _dirty_y1) _dirty_y1 = y1;
+      if (x2 > _dirty_x2) _dirty_x2 = x2;
+      if (y2 > _dirty_y2) _dirty_y2 = y2;
+    }
+    void _setDirtyBytes(uint32_t first, uint32_t last)
+    {
+      uint16_t wb = _pw_w / 8;
+      uint16_t y1 = first / wb;
+      uint16_t y2 = last / wb;
+      if (y1 == y2) _setDirty((first % wb) * 8, y1, (last % wb) * 8 + 7, y2);
+      else _setDirty(0, y1, _pw_w - 1, y2);
+    }
+    void _resetDirty()
+    {
+      _dirty_x1 = _dirty_y1 = 0xFFFF;
+      _dirty_x2 = _dirty_y2 = 0;
+    }
   private:
-    uint8_t _black_buffer[(GxEPD2_Type::WIDTH / 8) * page_height];
-    uint8_t _color_buffer[(GxEPD2_Type::WIDTH / 8) * page_height];
+    uint8_t _page_buffer[2 * (GxEPD2_Type::WIDTH / 8) * page_height];
+    uint8_t* _black_buffer;
+    uint8_t* _color_buffer;
+    uint8_t* _buffer_base; // the planes are in one of its halves with ping-pong buffers
+    uint32_t _buffer_size; // bytes per plane
     bool _using_partial_mode, _second_phase, _mirror;
     uint16_t _width_bytes, _pixel_bytes;
     int16_t _current_page;
     uint16_t _pages, _page_height;
     uint16_t _pw_x, _pw_y, _pw_w, _pw_h;
+    GxEPD2_Region _windows[max_partial_windows]; // controller coordinates
+    uint8_t _window_count, _current_window;
+    uint16_t _dirty_x1, _dirty_y1, _dirty_x2, _dirty_y2; // changed region in buffer coordinates, inclusive
+    GxEPD2_RefreshPolicy* _policy;
+    GxEPD2_GlyphCache* _glyph_cache;
+    const uint8_t* _background; // black plane
+    const uint8_t* _background_color;
+    bool _background_pgm;
+    void (*_background_callback)(const void*);
+    const void* _background_pv;
+    uint32_t _color_hash; // of the color buffer content on screen, 0 : unknown
+    bool _ping_pong;
+#if defined(ESP32)
+    struct WriteJob
+    {
+      const uint8_t* black;
+      const uint8_t* color;
+      uint16_t x, y, w, h;
+    };
+    WriteJob _write_job;
+    TaskHandle_t _writer;
+    SemaphoreHandle_t _write_request, _write_done;
+#endif
 };
 
 #endif
@@ -0,0 +1,551 @@
+// Display Library for SPI e-paper panels from Dalian Good Display and boards from Waveshare.
+// Requires HW SPI and Adafruit_GFX. Caution: these e-papers require 3.3V supply AND data lines!
+//
+// based on Demo Example from Good Display: http://www.good-display.com/download_list/downloadcategoryid=34&isMode=false.html
+//
+// Author: Jean-Marc Zingg
+//
+// Version: see library.properties
+//
+// Library: https://github.com/ZinggJM/GxEPD2
+
+#ifndef _GxEPD2_4G_H_
+#define _GxEPD2_4G_H_
+
+#include <Adafruit_GFX.h>
+#include "GxEPD2_EPD.h"
+#include "GxEPD2_RefreshPlanner.h"
+#include "GxEPD2_RefreshPolicy.h"
+#include "GxEPD2_GlyphCache.h"
+#include "epd/GxEPD2_270.h"
+#include "epd/GxEPD2_420.h"
+#include "epd/GxEPD2_583.h"
+#include "epd/GxEPD2_750.h"
+
+#ifndef ENABLE_GxEPD2_GFX
+// default is off
+#define ENABLE_GxEPD2_GFX 0
+#endif
+
+#if ENABLE_GxEPD2_GFX
+#include "GxEPD2_GFX.h"
+#endif
+
+// 4 grey levels: GxEPD_BLACK, GxEPD_DARKGREY, GxEPD_LIGHTGREY, GxEPD_WHITE; other colors by luminance
+// 2bpp page buffer, for drivers with writeImage4G() and refresh4G(): GxEPD2_270, GxEPD2_420, GxEPD2_583, GxEPD2_750
+template<typename GxEPD2_Type, const uint16_t page_height>
+#if ENABLE_GxEPD2_GFX
+class GxEPD2_4G : public GxEPD2_GFX
+#else
+class GxEPD2_4G : public Adafruit_GFX
+#endif
+{
+  public:
+    GxEPD2_Type epd2;
+#if ENABLE_GxEPD2_GFX
+    GxEPD2_4G(GxEPD2_Type epd2_instance) : epd2(epd2_instance), GxEPD2_GFX(epd2, GxEPD2_Type::WIDTH, GxEPD2_Type::HEIGHT)
+#else
+    GxEPD2_4G(GxEPD2_Type epd2_instance) : Adafruit_GFX(GxEPD2_Type::WIDTH, GxEPD2_Type::HEIGHT), epd2(epd2_instance)
+#endif
+    {
+      _setPageBuffer(0, 0);
+      _using_partial_mode = false;
+      _current_page = 0;
+      _resetDirty();
+      _mirror = false;
+      setFullWindow();
+    }
+
+    // page buffer provided by the application, e.g. in PSRAM; page height and number of pages follow from buffer_size
+    // the embedded buffer of page_height rows is used if buffer is NULL or too small for one row; use page_height 1 to keep it small
+#if ENABLE_GxEPD2_GFX
+    GxEPD2_4G(GxEPD2_Type epd2_instance, uint8_t* buffer, uint32_t buffer_size) : epd2(epd2_instance), GxEPD2_GFX(epd2, GxEPD2_Type::WIDTH, GxEPD2_Type::HEIGHT)
+#else
+    GxEPD2_4G(GxEPD2_Type epd2_instance, uint8_t* buffer, uint32_t buffer_size) : Adafruit_GFX(GxEPD2_Type::WIDTH, GxEPD2_Type::HEIGHT), epd2(epd2_instance)
+#endif
+    {
+      _setPageBuffer(buffer, buffer_size);
+      _using_partial_mode = false;
+      _current_page = 0;
+      _resetDirty();
+      _mirror = false;
+      setFullWindow();
+    }
+
+    bool mirror(bool m)
+    {
+      swap (_mirror, m);
+      return m;
+    }
+
+    void drawPixel(int16_t x, int16_t y, uint16_t color)
+    {
+      if ((x < 0) || (x >= width()) || (y < 0) || (y >= height())) return;
+      if (_mirror) x = width() - x - 1;
+      // check rotation, move pixel around if necessary
+      switch (getRotation())
+      {
+        case 1:
+          swap(x, y);
+          x = WIDTH - x - 1;
+          break;
+        case 2:
+          x = WIDTH - x - 1;
+          y = HEIGHT - y - 1;
+          break;
+        case 3:
+          swap(x, y);
+          y = HEIGHT - y - 1;
+          break;
+      }
+      // transpose partial window to 0,0
+      x -= _pw_x;
+      y -= _pw_y;
+      // adjust for current page
+      y -= _current_page * _page_height;
+      // check if in window and current page
+      if ((x < 0) || (x >= _pw_w) || (y < 0) || (y >= _page_height)) return;
+      uint32_t i = x / 4 + uint32_t(y) * (_pw_w / 4);
+      uint8_t shift = 6 - 2 * (x % 4);
+      uint8_t data = _buffer[i];
+      _buffer[i] = (_buffer[i] & ~(0x03 << shift)) | (_greyLevel(color) << shift);
+      if (_buffer[i] != data) _setDirty(x, y, x, y);
+    }
+
+    void init(uint32_t serial_diag_bitrate = 0) // = 0 : disabled
+    {
+      epd2.init(serial_diag_bitrate);
+      _using_partial_mode = false;
+      _current_page = 0;
+      setFullWindow();
+    }
+
+    void fillScreen(uint16_t color) // to buffer, grey level of color
+    {
+      uint8_t data = _greyLevel(color) * 0x55;
+      int32_t first = -1, last = -1; // changed bytes
+      for (uint32_t x = 0; x < _usedBytes(); x++)
+      {
+        if (_buffer[x] == data) continue;
+        _buffer[x] = data;
+        if (first < 0) first = x;
+        last = x;
+      }
+      if (first >= 0) _setDirtyBytes(first, last);
+    }
+
+    // display buffer content to screen, useful for full screen buffer
+    // grey levels always need the full waveform, partial_update_mode is ignored
+    void display(bool partial_update_mode = false)
+    {
+      epd2.writeImage4G(_buffer, 0, 0, WIDTH, HEIGHT);
+      epd2.refresh4G(0, 0, WIDTH, HEIGHT);
+      _resetDirty();
+    }
+
+    // write and refresh only the byte aligned region changed since last display, for full screen buffer
+    // the changed buffer rows are written with window width, the refresh is limited to the region
+    void displayChanged()
+    {
+      if (_dirty_x1 > _dirty_x2) return; // nothing changed
+      uint16_t x1 = _dirty_x1 - _dirty_x1 % 8;
+      uint16_t x2 = _dirty_x2 | 0x0007;
+      uint16_t y1 = _dirty_y1;
+      uint16_t y2 = gx_uint16_min(_dirty_y2, gx_uint16_min(_pw_h, _page_height) - 1);
+      if (y1 > y2) return;
+      uint16_t h = y2 - y1 + 1;
+      _writeRows(_pw_y + y1, _pw_y + y2);
+      epd2.refresh4G(_pw_x + x1, _pw_y + y1, x2 - x1 + 1, h);
+      _resetDirty();
+    }
+
+    // write and refresh regions (display coordinates), for full screen buffer
+    // a grey refresh has no fixed cost to save by merging, each region is refreshed on its own
+    void displayRegions(const GxEPD2_Region regions[], uint8_t count)
+    {
+      for (uint8_t i = 0; i < count; i++)
+      {
+        uint16_t x = regions[i].x, y = regions[i].y, w = regions[i].w, h = regions[i].h;
+        // mirror, then rotate, as drawing does
+        if (_mirror)
+        {
+          if (x + w > width()) w = x < width() ? width() - x : 0;
+          x = width() - x - w;
+        }
+        _rotate(x, y, w, h);
+        // limit to window and buffer
+        uint16_t x1 = gx_uint16_max(x, _pw_x);
+        uint16_t y1 = gx_uint16_max(y, _pw_y);
+        uint16_t x2 = gx_uint16_min(x + w, _pw_x + _pw_w);
+        uint16_t y2 = gx_uint16_min(y + h, _pw_y + gx_uint16_min(_pw_h, _page_height));
+        if ((x2 <= x1) || (y2 <= y1)) continue;
+        _writeRows(y1, y2 - 1);
+        epd2.refresh4G(x1, y1, x2 - x1, y2 - y1);
+      }
+    }
+
+    void setFullWindow()
+    {
+      _using_partial_mode = false;
+      _pw_x = 0;
+      _pw_y = 0;
+      _pw_w = WIDTH;
+      _pw_h = HEIGHT;
+      _planPages();
+      _setDirty(0, 0, _pw_w - 1, _pw_h - 1);
+    }
+
+    void setPartialWindow(uint16_t x, uint16_t y, uint16_t w, uint16_t h)
+    {
+      _rotate(x, y, w, h);
+      _using_partial_mode = true;
+      _pw_x = gx_uint16_min(x, WIDTH);
+      _pw_y = gx_uint16_min(y, HEIGHT);
+      _pw_w = gx_uint16_min(w, WIDTH - _pw_x);
+      _pw_h = gx_uint16_min(h, HEIGHT - _pw_y);
+      // make _pw_x, _pw_w multiple of 8
+      _pw_w += _pw_x % 8;
+      if (_pw_w % 8 > 0) _pw_w += 8 - _pw_w % 8;
+      _pw_x -= _pw_x % 8;
+      _planPages();
+      _setDirty(0, 0, _pw_w - 1, _pw_h - 1);
+    }
+
+    void firstPage()
+    {
+      fillScreen(GxEPD_WHITE);
+      _current_page = 0;
+    }
+
+    bool nextPage()
+    {
+      uint16_t page_ys = _current_page * _page_height;
+      if (_using_partial_mode)
+      {
+        uint16_t page_ye = _current_page < (_pages - 1) ? page_ys + _page_height : HEIGHT;
+        uint16_t dest_ys = _pw_y + page_ys; // transposed
+        uint16_t dest_ye = gx_uint16_min(_pw_y + _pw_h, _pw_y + page_ye);
+        if (dest_ye > dest_ys)
+        {
+          epd2.writeImage4G(_buffer, _pw_x, dest_ys, _pw_w, dest_ye - dest_ys);
+        }
+        _current_page++;
+        if (_current_page == _pages)
+        {
+          _current_page = 0;
+          epd2.refresh4G(_pw_x, _pw_y, _pw_w, _pw_h);
+          _resetDirty();
+          return false;
+        }
+        fillScreen(GxEPD_WHITE);
+        return true;
+      }
+      else
+      {
+        epd2.writeImage4G(_buffer, 0, page_ys, WIDTH, gx_uint16_min(_page_height, HEIGHT - page_ys));
+        _current_page++;
+        if (_current_page == _pages)
+        {
+          _current_page = 0;
+          epd2.refresh4G(0, 0, WIDTH, HEIGHT);
+          epd2.powerOff();
+          _resetDirty();
+          return false;
+        }
+        fillScreen(GxEPD_WHITE);
+        return true;
+      }
+    }
+
+    // GxEPD style paged drawing; drawCallback() is called as many times as needed
+    void drawPaged(void (*drawCallback)(const void*), const void* pv)
+    {
+      if (_using_partial_mode)
+      {
+        for (_current_page = 0; _current_page < _pages; _current_page++)
+        {
+          uint16_t page_ys = _current_page * _page_height;
+          uint16_t page_ye = _current_page < (_pages - 1) ? page_ys + _page_height : HEIGHT;
+          uint16_t dest_ys = _pw_y + page_ys; // transposed
+          uint16_t dest_ye = gx_uint16_min(_pw_y + _pw_h, _pw_y + page_ye);
+          if (dest_ye > dest_ys)
+          {
+            fillScreen(GxEPD_WHITE);
+            drawCallback(pv);
+            epd2.writeImage4G(_buffer, _pw_x, dest_ys, _pw_w, dest_ye - dest_ys);
+          }
+        }
+        epd2.refresh4G(_pw_x, _pw_y, _pw_w, _pw_h);
+      }
+      else
+      {
+        for (_current_page = 0; _current_page < _pages; _current_page++)
+        {
+          uint16_t page_ys = _current_page * _page_height;
+          fillScreen(GxEPD_WHITE);
+          drawCallback(pv);
+          epd2.writeImage4G(_buffer, 0, page_ys, WIDTH, gx_uint16_min(_page_height, HEIGHT - page_ys));
+        }
+        epd2.refresh4G(0, 0, WIDTH, HEIGHT);
+      }
+      _current_page = 0;
+      _resetDirty();
+    }
+
+    void drawInvertedBitmap(int16_t x, int16_t y, const uint8_t bitmap[], int16_t w, int16_t h, uint16_t color)
+    {
+      if (!intersectsPage(x, y, w, h)) return;
+      // taken from Adafruit_GFX.cpp, modified
+      int16_t byteWidth = (w + 7) / 8; // Bitmap scanline pad = whole byte
+      uint8_t byte = 0;
+      for (int16_t j = 0; j < h; j++)
+      {
+        for (int16_t i = 0; i < w; i++ )
+        {
+          if (i & 7) byte <<= 1;
+          else
+          {
+#if defined(__AVR) || defined(ESP8266) || defined(ESP32)
+            byte = pgm_read_byte(&bitmap[j * byteWidth + i / 8]);
+#else
+            byte = bitmap[j * byteWidth + i / 8];
+#endif
+          }
+          if (!(byte & 0x80))
+          {
+            drawPixel(x + i, y + j, color);
+          }
+        }
+      }
+    }
+
+    // current page in display coordinates (rotation and mirror applied), for culling in paged drawing
+    void getPageBounds(int16_t& x, int16_t& y, int16_t& w, int16_t& h)
+    {
+      uint16_t bx = _pw_x;
+      uint16_t by = _pw_y + _current_page * _page_height;
+      uint16_t bw = _pw_w;
+      uint16_t bh = by < _pw_y + _pw_h ? gx_uint16_min(_page_height, _pw_y + _pw_h - by) : 0;
+      switch (getRotation())
+      {
+        case 1:
+          x = by;
+          y = WIDTH - bx - bw;
+          w = bh;
+          h = bw;
+          break;
+        case 2:
+          x = WIDTH - bx - bw;
+          y = HEIGHT - by - bh;
+          w = bw;
+          h = bh;
+          break;
+        case 3:
+          x = HEIGHT - by - bh;
+          y = bx;
+          w = bh;
+          h = bw;
+          break;
+        default:
+          x = bx;
+          y = by;
+          w = bw;
+          h = bh;
+      }
+      if (_mirror) x = width() - x - w;
+    }
+
+    // false if rectangle x, y, w, h (display coordinates) misses the current page, nothing to draw
+    bool intersectsPage(int16_t x, int16_t y, int16_t w, int16_t h)
+    {
+      int16_t px, py, pw, ph;
+      getPageBounds(px, py, pw, ph);
+      return (x < px + pw) && (px < int32_t(x) + w) && (y < py + ph) && (py < int32_t(y) + h);
+    }
+
+    // lines missing the current page are skipped
+    void drawLine(int16_t x0, int16_t y0, int16_t x1, int16_t y1, uint16_t color)
+    {
+      int16_t x = x0 < x1 ? x0 : x1;
+      int16_t y = y0 < y1 ? y0 : y1;
+      if (!intersectsPage(x, y, abs(x1 - x0) + 1, abs(y1 - y0) + 1)) return;
+      Adafruit_GFX::drawLine(x0, y0, x1, y1, color);
+    }
+
+    // text glyphs missing the current page only advance the cursor
+    size_t write(uint8_t c)
+    {
+      GxEPD2_GlyphCache::Placement p;
+      if (!GxEPD2_GlyphCache::place(*this, gfxFont, c, p) || intersectsPage(p.x, p.y, p.w, p.h)) return Adafruit_GFX::write(c);
+      setCursor(p.cursor_x, p.cursor_y);
+      return 1;
+    }
+
+    //  Support for Bitmaps (Sprites) to Controller Buffer and to Screen
+    void clearScreen(uint8_t value = 0xFF) // init controller memory and screen (default white)
+    {
+      epd2.clearScreen(value);
+    }
+    void writeScreenBuffer(uint8_t value = 0xFF) // init controller memory (default white)
+    {
+      epd2.writeScreenBuffer(value);
+    }
+    // write to controller memory, without screen refresh; x and w should be multiple of 8
+    void writeImage(const uint8_t bitmap[], int16_t x, int16_t y, int16_t w, int16_t h, bool invert = false, bool mirror_y = false, bool pgm = false)
+    {
+      epd2.writeImage(bitmap, x, y, w, h, invert, mirror_y, pgm);
+    }
+    void writeImage(const uint8_t* black, const uint8_t* color, int16_t x, int16_t y, int16_t w, int16_t h, bool invert = false, bool mirror_y = false, bool pgm = false)
+    {
+      epd2.writeImage(black, color, x, y, w, h, invert, mirror_y, pgm);
+    }
+    // write 2bpp grey level bitmap to controller memory, without screen refresh; x and w should be multiple of 8
+    void writeImage4G(const uint8_t bitmap[], int16_t x, int16_t y, int16_t w, int16_t h, bool invert = false, bool mirror_y = false, bool pgm = false)
+    {
+      epd2.writeImage4G(bitmap, x, y, w, h, invert, mirror_y, pgm);
+    }
+    // write sprite of native data to controller memory, without screen refresh; x and w should be multiple of 8
+    void writeNative(const uint8_t* data1, const uint8_t* data2, int16_t x, int16_t y, int16_t w, int16_t h, bool invert, bool mirror_y, bool pgm)
+    {
+      epd2.writeNative(data1, data2, x, y, w, h, invert, mirror_y, pgm);
+    }
+    // write to controller memory, with screen refresh; x and w should be multiple of 8
+    void drawImage(const uint8_t bitmap[], int16_t x, int16_t y, int16_t w, int16_t h, bool invert = false, bool mirror_y = false, bool pgm = false)
+    {
+      epd2.drawImage(bitmap, x, y, w, h, invert, mirror_y, pgm);
+    }
+    void drawImage(const uint8_t* black, const uint8_t* color, int16_t x, int16_t y, int16_t w, int16_t h, bool invert = false, bool mirror_y = false, bool pgm = false)
+    {
+      epd2.drawImage(black, color, x, y, w, h, invert, mirror_y, pgm);
+    }
+    // write 2bpp grey level bitmap to controller memory, with screen refresh; x and w should be multiple of 8
+    void drawImage4G(const uint8_t bitmap[], int16_t x, int16_t y, int16_t w, int16_t h, bool invert = false, bool mirror_y = false, bool pgm = false)
+    {
+      epd2.writeImage4G(bitmap, x, y, w, h, invert, mirror_y, pgm);
+      epd2.refresh4G(x, y, w, h);
+    }
+    // write sprite of native data to controller memory, with screen refresh; x and w should be multiple of 8
+    void drawNative(const uint8_t* data1, const uint8_t* data2, int16_t x, int16_t y, int16_t w, int16_t h, bool invert, bool mirror_y, bool pgm)
+    {
+      epd2.drawNative(data1, data2, x, y, w, h, invert, mirror_y, pgm);
+    }
+    void refresh(bool partial_update_mode = false) // screen refresh from controller memory to full screen
+    {
+      epd2.refresh(partial_update_mode);
+    }
+    void refresh(int16_t x, int16_t y, int16_t w, int16_t h) // screen refresh from controller memory, partial screen
+    {
+      epd2.refresh(x, y, w, h);
+    }
+    void powerOff()
+    {
+      epd2.powerOff();
+    }
+  private:
+    template <typename T> static inline void
+    swap(T & a, T & b)
+    {
+      T t = a;
+      a = b;
+      b = t;
+    };
+    static inline uint16_t gx_uint16_min(uint16_t a, uint16_t b)
+    {
+      return (a < b ? a : b);
+    };
+    static inline uint16_t gx_uint16_max(uint16_t a, uint16_t b)
+    {
+      return (a > b ? a : b);
+    };
+    void _setPageBuffer(uint8_t* buffer, uint32_t buffer_size)
+    {
+      uint32_t rows = buffer ? buffer_size / (GxEPD2_Type::WIDTH / 4) : 0;
+      if (rows == 0)
+      {
+        buffer = _page_buffer;
+        rows = page_height;
+      }
+      _page_height = rows < uint32_t(GxEPD2_Type::HEIGHT) ? rows : GxEPD2_Type::HEIGHT;
+      _pages = (HEIGHT / _page_height) + ((HEIGHT % _page_height) > 0);
+      _buffer_size = uint32_t(GxEPD2_Type::WIDTH / 4) * _page_height;
+      _buffer = buffer;
+    }
+    // page height and number of pages for the current window; a narrow partial window uses the whole buffer for taller pages
+    void _planPages()
+    {
+      uint16_t wb = gx_uint16_max(_pw_w / 4, 1);
+      uint16_t h = gx_uint16_max(_pw_h, 1);
+      uint32_t rows = _buffer_size / wb;
+      _page_height = rows < h ? rows : h;
+      _pages = (h / _page_height) + ((h % _page_height) > 0);
+    }
+    // buffer bytes of a page of the current window
+    uint32_t _usedBytes()
+    {
+      return uint32_t(_page_height) * (_pw_w / 4);
+    }
+    // 0 black, 1 dark grey, 2 light grey, 3 white; rounded luminance of RGB565 color
+    static uint8_t _greyLevel(uint16_t color)
+    {
+      uint16_t r = (color >> 8) & 0xF8, g = (color >> 3) & 0xFC, b = (color << 3) & 0xF8;
+      uint16_t luminance = (r * 77 + g * 150 + b * 29) >> 8;
+      return (luminance + 42) / 85;
+    }
+    void _rotate(uint16_t& x, uint16_t& y, uint16_t& w, uint16_t& h)
+    {
+      switch (getRotation())
+      {
+        case 1:
+          swap(x, y);
+          swap(w, h);
+          x = WIDTH - x - w;
+          break;
+        case 2:
+          x = WIDTH - x - w;
+          y = HEIGHT - y - h;
+          break;
+        case 3:
+          swap(x, y);
+          swap(w, h);
+          y = HEIGHT - y - h;
+          break;
+      }
+    }
+    // write buffer rows of window width for controller rows ys to ye inclusive
+    void _writeRows(uint16_t ys, uint16_t ye)
+    {
+      uint32_t offset = uint32_t(ys - _pw_y) * (_pw_w / 4);
+      epd2.writeImage4G(_buffer + offset, _pw_x, ys, _pw_w, ye - ys + 1);
+    }
+    void _setDirty(uint16_t x1, uint16_t y1, uint16_t x2, uint16_t y2)
+    {
+      if (x1 < _dirty_x1) _dirty_x1 = x1;
+      if (y1 < _dirty_y1) _dirty_y1 = y1;
+      if (x2 > _dirty_x2) _dirty_x2 = x2;
+      if (y2 > _dirty_y2) _dirty_y2 = y2;
+    }
+    void _setDirtyBytes(uint32_t first, uint32_t last)
+    {
+      uint16_t wb = _pw_w / 4;
+      uint16_t y1 = first / wb;
+      uint16_t y2 = last / wb;
+      if (y1 == y2) _setDirty((first % wb) * 4, y1, (last % wb) * 4 + 3, y2);
+      else _setDirty(0, y1, _pw_w - 1, y2);
+    }
+    void _resetDirty()
+    {
+      _dirty_x1 = _dirty_y1 = 0xFFFF;
+      _dirty_x2 = _dirty_y2 = 0;
+    }
+  private:
+    uint8_t _page_buffer[(GxEPD2_Type::WIDTH / 4) * page_height];
+    uint8_t* _buffer;
+    uint32_t _buffer_size;
+    bool _using_partial_mode, _mirror;
+    int16_t _current_page;
+    uint16_t _pages, _page_height;
+    uint16_t _pw_x, _pw_y, _pw_w, _pw_h;
+    uint16_t _dirty_x1, _dirty_y1, _dirty_x2, _dirty_y2; // changed region in buffer coordinates, inclusive
+};
+
+#endif
@@ -14,6 +14,12 @@
 
 #include <Adafruit_GFX.h>
 #include "GxEPD2_EPD.h"
+#include "GxEPD2_RefreshPlanner.h"
+#include "GxEPD2_RefreshPolicy.h"
+#include "GxEPD2_GlyphCache.h"
+#if defined(ESP32)
+#include <freertos/semphr.h>
+#endif
 #include "epd/GxEPD2_154.h"
 #include "epd/GxEPD2_213.h"
 #include "epd/GxEPD2_290.h"
@@ -31,7 +37,9 @@
 #include "GxEPD2_GFX.h"
 #endif
 
-template<typename GxEPD2_Type, const uint16_t page_height>
+// fixed_rotation 0..3 : rotation and mirror (fixed_mirror) are compile time constants, setRotation() and mirror() keep them
+// the pixel transform is then straight-line code; default -1 : runtime rotation and mirror
+template<typename GxEPD2_Type, const uint16_t page_height, const int8_t fixed_rotation = -1, const bool fixed_mirror = false>
 #if ENABLE_GxEPD2_GFX
 class GxEPD2_BW : public GxEPD2_GFX
 #else
@@ -40,44 +48,98 @@ class GxEPD2_BW : public Adafruit_GFX
 {
   public:
     GxEPD2_Type epd2;
+    static const uint8_t max_partial_windows = 4; // for setPartialWindows()
 #if ENABLE_GxEPD2_GFX
     GxEPD2_BW(GxEPD2_Type epd2_instance) : epd2(epd2_instance), GxEPD2_GFX(epd2, GxEPD2_Type::WIDTH, GxEPD2_Type::HEIGHT) 
 #else
     GxEPD2_BW(GxEPD2_Type epd2_instance) : Adafruit_GFX(GxEPD2_Type::WIDTH, GxEPD2_Type::HEIGHT), epd2(epd2_instance)
 #endif
     {
-      _page_height = page_height;
-      _pages = (HEIGHT / _page_height) + ((HEIGHT % _page_height) > 0);
-      _reverse = (epd2_instance.panel == GxEPD2::GDE0213B1);
+      _setPageBuffer(0, 0);
+      _using_partial_mode = false;
+      _current_page = 0;
+      _row_hash = 0;
+      _resetDirty();
+      _policy = 0;
+      _glyph_cache = 0;
+      _background = 0;
+      _background_callback = 0;
+      _ping_pong = false;
+#if defined(ESP32)
+      _writer = 0;
+      _write_request = 0;
+      _write_done = 0;
+#endif
+      _mirror = false;
+      setRotation(0); // fixed_rotation, if any
+      setFullWindow();
+    }
+
+    // page buffer provided by the application, e.g. in PSRAM; page height and number of pages follow from buffer_size
+    // the embedded buffer of page_height rows is used if buffer is NULL or too small for one row; use page_height 1 to keep it small
+#if ENABLE_GxEPD2_GFX
+    GxEPD2_BW(GxEPD2_Type epd2_instance, uint8_t* buffer, uint32_t buffer_size) : epd2(epd2_instance), GxEPD2_GFX(epd2, GxEPD2_Type::WIDTH, GxEPD2_Type::HEIGHT) 
+#else
+    GxEPD2_BW(GxEPD2_Type epd2_instance, uint8_t* buffer, uint32_t buffer_size) : Adafruit_GFX(GxEPD2_Type::WIDTH, GxEPD2_Type::HEIGHT), epd2(epd2_instance)
+#endif
+    {
+      _setPageBuffer(buffer, buffer_size);
       _using_partial_mode = false;
       _current_page = 0;
+      _row_hash = 0;
+      _resetDirty();
+      _policy = 0;
+      _glyph_cache = 0;
+      _background = 0;
+      _background_callback = 0;
+      _ping_pong = false;
+#if defined(ESP32)
+      _writer = 0;
+      _write_request = 0;
+      _write_done = 0;
+#endif
+      _mirror = false;
+      setRotation(0); // fixed_rotation, if any
       setFullWindow();
     }
 
+#if defined(ESP32)
+    ~GxEPD2_BW()
+    {
+      setPingPong(false); // stops the writer task
+    }
+#endif
+
     bool mirror(bool m)
     {
+      if (fixed_rotation >= 0) return fixed_mirror;
       swap (_mirror, m);
       return m;
     }
 
+    void setRotation(uint8_t r)
+    {
+      Adafruit_GFX::setRotation(fixed_rotation < 0 ? r : fixed_rotation);
+    }
+
     void drawPixel(int16_t x, int16_t y, uint16_t color)
     {
-      if ((x < 0) || (x >= width()) || (y < 0) || (y >= height())) return;
-      if (_mirror) x = width() - x - 1;
+      if ((x < 0) || (x >= _displayWidth()) || (y < 0) || (y >= _displayHeight())) return;
+      if (_mirrored()) x = _displayWidth() - x - 1;
       // check rotation, move pixel around if necessary
-      switch (getRotation())
+      switch (_rotation())
       {
         case 1:
           swap(x, y);
-          x = WIDTH - x - 1;
+          x = GxEPD2_Type::WIDTH - x - 1;
           break;
         case 2:
-          x = WIDTH - x - 1;
-          y = HEIGHT - y - 1;
+          x = GxEPD2_Type::WIDTH - x - 1;
+          y = GxEPD2_Type::HEIGHT - y - 1;
           break;
         case 3:
           swap(x, y);
-          y = HEIGHT - y - 1;
+          y = GxEPD2_Type::HEIGHT - y - 1;
           break;
       }
       // transpose partial window to 0,0
@@ -85,14 +147,15 @@ class GxEPD2_BW : public Adafruit_GFX
       y -= _pw_y;
       // adjust for current page
       y -= _current_page * _page_height;
-      if (_reverse) y = _page_height - y - 1;
-      // check if in current page
-      if ((y < 0) || (y >= _page_height)) return;
-      uint16_t i = x / 8 + y * (_pw_w / 8);
+      // check if in window and current page
+      if ((x < 0) || (x >= _pw_w) || (y < 0) || (y >= _page_height)) return;
+      uint32_t i = x / 8 + uint32_t(y) * (_pw_w / 8);
+      uint8_t data = _buffer[i];
       if (color)
         _buffer[i] = (_buffer[i] | (1 << (7 - x % 8)));
       else
         _buffer[i] = (_buffer[i] & (0xFF ^ (1 << (7 - x % 8))));
+      if (_buffer[i] != data) _setDirty(x, y, x, y);
     }
 
     void init(uint32_t serial_diag_bitrate = 0) // = 0 : disabled
@@ -100,23 +163,189 @@ class GxEPD2_BW : public Adafruit_GFX
       epd2.init(serial_diag_bitrate);
       _using_partial_mode = false;
       _current_page = 0;
+      _invalidateRowHashes();
       setFullWindow();
     }
 
+    // optional differential write: rows with unchanged content are not written to controller memory again
+    // hash_table needs HEIGHT entries, provided by the application; NULL disables (default)
+    // only valid as long as controller memory is written through this class
+    void setRowHashTable(uint32_t* hash_table)
+    {
+      _row_hash = hash_table;
+      _invalidateRowHashes();
+    }
+
     void fillScreen(uint16_t color) // 0x0 black, >0x0 white, to buffer
     {
-      uint8_t data = (color == GxEPD_BLACK) ? 0x00 : 0xFF;
-      for (uint16_t x = 0; x < sizeof(_buffer); x++)
-      {
-        _buffer[x] = data;
-      }
+      int32_t first = -1, last = -1; // changed bytes
+      _ropSpan(_buffer, 0, _usedBytes(), (color == GxEPD_BLACK) ? 0x00 : 0xFF, GxEPD2::RopCopy, first, last);
+      if (first >= 0) _setDirtyBytes(first, last);
+    }
+
+    void drawFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color)
+    {
+      fillRect(x, y, w, 1, color);
+    }
+
+    void drawFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color)
+    {
+      fillRect(x, y, 1, h, color);
+    }
+
+    // clipped once, then written 32 bits at a time with masked edge bytes, any rotation
+    void fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color)
+    {
+      uint16_t bx, by, bw, bh;
+      if (!_clipRect(x, y, w, h, bx, by, bw, bh)) return;
+      if (_ropRect(_buffer, bx, by, bw, bh, color ? 0xFF : 0x00, GxEPD2::RopCopy)) _setDirty(bx, by, bx + bw - 1, by + bh - 1);
+    }
+
+    // fill combined with the buffer content by op, GxEPD2::RopCopy, RopOr, RopAnd or RopXor; bitwise on pixel values, white is 1
+    void fillRectRop(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color, GxEPD2::RasterOp op)
+    {
+      uint16_t bx, by, bw, bh;
+      if (!_clipRect(x, y, w, h, bx, by, bw, bh)) return;
+      if (_ropRect(_buffer, bx, by, bw, bh, color ? 0xFF : 0x00, op)) _setDirty(bx, by, bx + bw - 1, by + bh - 1);
+    }
+
+    // e.g. selection highlight or cursor blink, without drawing again
+    void invertRect(int16_t x, int16_t y, int16_t w, int16_t h)
+    {
+      fillRectRop(x, y, w, h, GxEPD_WHITE, GxEPD2::RopXor);
+    }
+
+    // masked sprite: pixels of set bitmap bits are combined with color by op, e.g. GxEPD2::RopXor with GxEPD_WHITE inverts them
+    void drawBitmapRop(int16_t x, int16_t y, const uint8_t bitmap[], int16_t w, int16_t h, uint16_t color, GxEPD2::RasterOp op, bool pgm = true)
+    {
+      _drawBitmap(bitmap, x, y, w, h, color, false, pgm, op);
     }
 
     // display buffer content to screen, useful for full screen buffer
     void display(bool partial_update_mode = false)
     {
-      epd2.writeImage(_buffer, 0, 0, WIDTH, HEIGHT);
-      epd2.refresh(partial_update_mode);
+      bool dual = !partial_update_mode && epd2.hasFastPartialUpdate && epd2.hasDualRamWrite;
+      if (_row_hash && epd2.hasFastPartialUpdate && !dual)
+      {
+        _writeImage(_buffer, 0, 0, WIDTH, HEIGHT, false);
+        _refresh(partial_update_mode);
+        // make both controller buffers have equal content
+        _writeImage(_buffer, 0, 0, WIDTH, HEIGHT, true);
+        _resetDirty();
+        return;
+      }
+      _writeImage(_buffer, 0, 0, WIDTH, HEIGHT, true, dual);
+      _refresh(partial_update_mode);
+      _resetDirty();
+    }
+
+    // write and refresh only the byte aligned region changed since last display, for full screen buffer
+    // the changed buffer rows are written with window width, the refresh is limited to the region
+    void displayChanged()
+    {
+      if (!epd2.hasPartialUpdate) return display(false);
+      if (_dirty_x1 > _dirty_x2) return; // nothing changed
+      uint16_t x1 = _dirty_x1 - _dirty_x1 % 8;
+      uint16_t x2 = _dirty_x2 | 0x0007;
+      uint16_t y1 = _dirty_y1;
+      uint16_t y2 = gx_uint16_min(_dirty_y2, gx_uint16_min(_pw_h, _page_height) - 1);
+      if (y1 > y2) return;
+      uint16_t h = y2 - y1 + 1;
+      _writeRows(_pw_y + y1, _pw_y + y2, !epd2.hasFastPartialUpdate);
+      _refresh(_pw_x + x1, _pw_y + y1, x2 - x1 + 1, h);
+      if (epd2.hasFastPartialUpdate)
+      {
+        // make both controller buffers have equal content
+        _writeRows(_pw_y + y1, _pw_y + y2, true);
+      }
+      _resetDirty();
+    }
+
+    // write and refresh regions (display coordinates) with the least estimated refresh time, for full screen buffer
+    // regions are refreshed separately, merged or replaced by a full refresh, see GxEPD2_RefreshPlanner
+    void displayRegions(const GxEPD2_Region regions[], uint8_t count)
+    {
+      GxEPD2_RefreshPlanner<GxEPD2_Type> planner;
+      for (uint8_t i = 0; i < count; i++)
+      {
+        uint16_t x = regions[i].x, y = regions[i].y, w = regions[i].w, h = regions[i].h;
+        // mirror, then rotate, as drawing does
+        if (_mirrored())
+        {
+          if (x + w > _displayWidth()) w = x < _displayWidth() ? _displayWidth() - x : 0;
+          x = _displayWidth() - x - w;
+        }
+        _rotate(x, y, w, h);
+        // limit to window and buffer
+        uint16_t x1 = gx_uint16_max(x, _pw_x);
+        uint16_t y1 = gx_uint16_max(y, _pw_y);
+        uint16_t x2 = gx_uint16_min(x + w, _pw_x + _pw_w);
+        uint16_t y2 = gx_uint16_min(y + h, _pw_y + gx_uint16_min(_pw_h, _page_height));
+        if ((x2 > x1) && (y2 > y1)) planner.add(x1, y1, x2 - x1, y2 - y1);
+      }
+      if (planner.plan(!_using_partial_mode) == 0) return;
+      if (planner.isFullRefresh()) return display(false);
+      _writeRegionRows(planner, !epd2.hasFastPartialUpdate);
+      _refresh(planner);
+      // make both controller buffers have equal content
+      if (epd2.hasFastPartialUpdate) _writeRegionRows(planner, true);
+      _resetDirty();
+    }
+
+    // attach policy for automatic full refresh after partial refreshes (ghosting); NULL detaches
+    void setRefreshPolicy(GxEPD2_RefreshPolicy* policy)
+    {
+      _policy = policy;
+      if (_policy) _policy->begin(WIDTH, HEIGHT);
+    }
+
+    // do a full refresh if the refresh policy has one pending, to be called when the screen is idle
+    bool idleRefresh()
+    {
+      if (!_policy || !_policy->fullRefreshPending()) return false;
+      _refresh(false);
+      return true;
+    }
+
+    // attach cache for GFXfont glyphs, text size 1 is then drawn by the byte-wise blitter; NULL detaches
+    void setGlyphCache(GxEPD2_GlyphCache* cache)
+    {
+      _glyph_cache = cache;
+    }
+
+    // ping-pong page buffers for paged drawing: the buffer is split in two pages, the finished page is written to the controller
+    // by a task on the other core while the next page is drawn; the picture loop and drawPaged() are used as before
+    // ESP32 only; returns false elsewhere, or if the buffer is too small for two pages of one row
+    bool setPingPong(bool enable)
+    {
+#if defined(ESP32)
+      if (enable == _ping_pong) return true;
+      if (enable)
+      {
+        if (_buffer_size / 2 < WIDTH / 8) return false;
+        _write_request = xSemaphoreCreateBinary();
+        _write_done = xSemaphoreCreateBinary();
+        if (_write_done) xSemaphoreGive(_write_done);
+        // the Arduino loop runs on core 1
+        if (!_write_request || !_write_done || (xTaskCreatePinnedToCore(_writeTask, "GxEPD2_write", 4096, this, 1, &_writer, 0) != pdPASS))
+        {
+          _writer = 0;
+          _deleteWriter();
+          return false;
+        }
+      }
+      else
+      {
+        _waitWrite();
+        _deleteWriter();
+      }
+      _ping_pong = enable;
+      _buffer = _buffer_base;
+      _planPages();
+      return true;
+#else
+      return !enable;
+#endif
     }
 
     void setFullWindow()
@@ -126,27 +355,78 @@ class GxEPD2_BW : public Adafruit_GFX
       _pw_y = 0;
       _pw_w = WIDTH;
       _pw_h = HEIGHT;
+      _planPages();
+      _setDirty(0, 0, _pw_w - 1, _pw_h - 1);
     }
 
     void setPartialWindow(uint16_t x, uint16_t y, uint16_t w, uint16_t h)
     {
-      _rotate(x, y, w, h);
+      GxEPD2_Region region = {x, y, w, h};
+      setPartialWindows(&region, 1);
+    }
+
+    // several partial windows (display coordinates) updated by one picture loop or drawPaged(), up to max_partial_windows
+    // each window is drawn and written in turn, then all are refreshed with the least estimated time, see GxEPD2_RefreshPlanner
+    void setPartialWindows(const GxEPD2_Region regions[], uint8_t count)
+    {
+      if (count == 0) return;
       _using_partial_mode = true;
-      _pw_x = gx_uint16_min(x, WIDTH);
-      _pw_y = gx_uint16_min(y, HEIGHT);
-      _pw_w = gx_uint16_min(w, WIDTH - _pw_x);
-      _pw_h = gx_uint16_min(h, HEIGHT - _pw_y);
-      // make _pw_x, _pw_w multiple of 8
-      _pw_w += _pw_x % 8;
-      if (_pw_w % 8 > 0) _pw_w += 8 - _pw_w % 8;
-      _pw_x -= _pw_x % 8;
+      _window_count = count < max_partial_windows ? count : max_partial_windows;
+      for (uint8_t i = 0; i < _window_count; i++)
+      {
+        uint16_t x = regions[i].x, y = regions[i].y, w = regions[i].w, h = regions[i].h;
+        _rotate(x, y, w, h);
+        _pw_x = gx_uint16_min(x, WIDTH);
+        _pw_y = gx_uint16_min(y, HEIGHT);
+        _pw_w = gx_uint16_min(w, WIDTH - _pw_x);
+        _pw_h = gx_uint16_min(h, HEIGHT - _pw_y);
+        // make _pw_x, _pw_w multiple of 8
+        _pw_w += _pw_x % 8;
+        if (_pw_w % 8 > 0) _pw_w += 8 - _pw_w % 8;
+        _pw_x -= _pw_x % 8;
+        _windows[i].x = _pw_x;
+        _windows[i].y = _pw_y;
+        _windows[i].w = _pw_w;
+        _windows[i].h = _pw_h;
+      }
+      _selectWindow(0);
+      _setDirty(0, 0, _pw_w - 1, _pw_h - 1);
+    }
+
+    // static background layer, the picture loop or drawCallback draws only the dynamic overlay
+    // bitmap in controller orientation and format, as for writeImage(), WIDTH x HEIGHT; copied to each page; NULL removes
+    void setBackground(const uint8_t* bitmap, bool pgm = true)
+    {
+      _background = bitmap;
+      _background_pgm = pgm;
+      _background_callback = 0;
+    }
+
+    // background drawn for each page by drawCallback, e.g. replay() of a GxEPD2_DisplayList or a decoder of compressed data
+    void setBackground(void (*drawCallback)(const void*), const void* pv)
+    {
+      _background = 0;
+      _background_callback = drawCallback;
+      _background_pv = pv;
+    }
+
+    // clear the buffer (current page) to the background, white if none; called by firstPage(), nextPage() and drawPaged()
+    // for full screen buffer use instead of fillScreen() before drawing the overlay
+    void drawBackground()
+    {
+      if (_background) _copyBackground(_buffer, _background);
+      else
+      {
+        fillScreen(GxEPD_WHITE);
+        if (_background_callback) _background_callback(_background_pv);
+      }
     }
 
     void firstPage()
     {
-      fillScreen(GxEPD_WHITE);
       _current_page = 0;
       _second_phase = false;
+      drawBackground();
     }
 
     bool nextPage()
@@ -163,8 +443,7 @@ class GxEPD2_BW : public Adafruit_GFX
         {
           //Serial.print("writeImage("); Serial.print(_pw_x); Serial.print(", "); Serial.print(dest_ys); Serial.print(", ");
           //Serial.print(_pw_w); Serial.print(", "); Serial.print(dest_ye - dest_ys); Serial.println(")");
-          uint32_t offset = _reverse ? (_page_height - (dest_ye - dest_ys)) * _pw_w / 8 : 0;
-          epd2.writeImage(_buffer + offset, _pw_x, dest_ys, _pw_w, dest_ye - dest_ys);
+          _writePage(_pw_x, dest_ys, _pw_w, dest_ye - dest_ys, _second_phase || !epd2.hasFastPartialUpdate);
         }
         else
         {
@@ -176,42 +455,69 @@ class GxEPD2_BW : public Adafruit_GFX
         if (_current_page == _pages)
         {
           _current_page = 0;
+          if (_current_window + 1 < _window_count)
+          {
+            _selectWindow(_current_window + 1);
+            _swapPageBuffer();
+            drawBackground();
+            return true;
+          }
+          _waitWrite();
+          _selectWindow(0);
           if (!_second_phase)
           {
-            epd2.refresh(_pw_x, _pw_y, _pw_w, _pw_h);
+            _refreshWindows();
             if (epd2.hasFastPartialUpdate)
             {
-              _second_phase = true;
-              return true;
+              if ((_pages > 1) || (_window_count > 1))
+              {
+                _second_phase = true;
+                drawBackground();
+                return true;
+              }
+              // buffer holds the whole window: make both controller buffers have equal content without drawing again
+              _writeImage(_buffer, _pw_x, _pw_y, _pw_w, _pw_h, true);
             }
           }
+          _resetDirty();
           return false;
         }
-        fillScreen(GxEPD_WHITE);
+        _swapPageBuffer();
+        drawBackground();
         return true;
       }
       else
       {
-        epd2.writeImage(_buffer, 0, page_ys, WIDTH, gx_uint16_min(_page_height, HEIGHT - page_ys));
+        // with dual ram write both controller buffers get equal content in this single pass, before the full refresh
+        bool dual = epd2.hasFastPartialUpdate && epd2.hasDualRamWrite;
+        _writePage(0, page_ys, WIDTH, gx_uint16_min(_page_height, HEIGHT - page_ys), _second_phase || !epd2.hasFastPartialUpdate || dual, dual);
         _current_page++;
         if (_current_page == _pages)
         {
           _current_page = 0;
-          if (epd2.hasFastPartialUpdate)
+          _waitWrite();
+          if (epd2.hasFastPartialUpdate && !dual)
           {
             if (!_second_phase)
             {
-              epd2.refresh(false);
-              _second_phase = true;
-              fillScreen(GxEPD_WHITE);
-              return true;
+              _refresh(false);
+              if (_pages > 1)
+              {
+                _second_phase = true;
+                drawBackground();
+                return true;
+              }
+              // full screen buffer: make both controller buffers have equal content without drawing again
+              _writeImage(_buffer, 0, 0, WIDTH, HEIGHT, true);
             }
-            else epd2.refresh(true);
-          } else epd2.refresh(false);
+            epd2.refresh(true);
+          } else _refresh(false);
           epd2.powerOff();
+          _resetDirty();
           return false;
         }
-        fillScreen(GxEPD_WHITE);
+        _swapPageBuffer();
+        drawBackground();
         return true;
       }
     }
@@ -223,121 +529,221 @@ class GxEPD2_BW : public Adafruit_GFX
       {
         for (uint16_t phase = 1; phase <= 2; phase++)
         {
-          for (_current_page = 0; _current_page < _pages; _current_page++)
+          for (uint8_t window = 0; window < _window_count; window++)
           {
-            uint16_t page_ys = _current_page * _page_height;
-            uint16_t page_ye = _current_page < (_pages - 1) ? page_ys + _page_height : HEIGHT;
-            uint16_t dest_ys = _pw_y + page_ys; // transposed
-            uint16_t dest_ye = gx_uint16_min(_pw_y + _pw_h, _pw_y + page_ye);
-            if (dest_ye > dest_ys)
+            _selectWindow(window);
+            for (_current_page = 0; _current_page < _pages; _current_page++)
             {
-              fillScreen(GxEPD_WHITE);
-              drawCallback(pv);
-              uint32_t offset = _reverse ? (_page_height - (dest_ye - dest_ys)) * _pw_w / 8 : 0;
-              epd2.writeImage(_buffer + offset, _pw_x, dest_ys, _pw_w, dest_ye - dest_ys);
+              uint16_t page_ys = _current_page * _page_height;
+              uint16_t page_ye = _current_page < (_pages - 1) ? page_ys + _page_height : HEIGHT;
+              uint16_t dest_ys = _pw_y + page_ys; // transposed
+              uint16_t dest_ye = gx_uint16_min(_pw_y + _pw_h, _pw_y + page_ye);
+              if (dest_ye > dest_ys)
+              {
+                _swapPageBuffer();
+                drawBackground();
+                drawCallback(pv);
+                _writePage(_pw_x, dest_ys, _pw_w, dest_ye - dest_ys, (phase == 2) || !epd2.hasFastPartialUpdate);
+              }
             }
           }
-          epd2.refresh(_pw_x, _pw_y, _pw_w, _pw_h);
+          _waitWrite();
+          _selectWindow(0);
+          _refreshWindows();
           if (!epd2.hasFastPartialUpdate) break;
           // else make both controller buffers have equal content
+          if ((_pages == 1) && (_window_count == 1))
+          {
+            // buffer holds the whole window, no need to draw again
+            _writeImage(_buffer, _pw_x, _pw_y, _pw_w, _pw_h, true);
+            break;
+          }
         }
       }
       else
       {
+        // with dual ram write both controller buffers get equal content in a single pass, before the full refresh
+        bool dual = epd2.hasFastPartialUpdate && epd2.hasDualRamWrite;
         for (_current_page = 0; _current_page < _pages; _current_page++)
         {
           uint16_t page_ys = _current_page * _page_height;
-          fillScreen(GxEPD_WHITE);
+          _swapPageBuffer();
+          drawBackground();
           drawCallback(pv);
-          epd2.writeImage(_buffer, 0, page_ys, WIDTH, gx_uint16_min(_page_height, HEIGHT - page_ys));
+          _writePage(0, page_ys, WIDTH, gx_uint16_min(_page_height, HEIGHT - page_ys), !epd2.hasFastPartialUpdate || dual, dual);
         }
-        epd2.refresh(false);
-        if (epd2.hasFastPartialUpdate)
+        _waitWrite();
+        _refresh(false);
+        if (epd2.hasFastPartialUpdate && !dual)
         {
-          // make both controller buffers have equal content
+          // make both controller buffers have equal content, drawing again only if the buffer is paged
           for (_current_page = 0; _current_page < _pages; _current_page++)
           {
             uint16_t page_ys = _current_page * _page_height;
-            fillScreen(GxEPD_WHITE);
-            drawCallback(pv);
-            epd2.writeImage(_buffer, 0, page_ys, WIDTH, gx_uint16_min(_page_height, HEIGHT - page_ys));
+            if (_pages > 1)
+            {
+              _swapPageBuffer();
+              drawBackground();
+              drawCallback(pv);
+            }
+            _writePage(0, page_ys, WIDTH, gx_uint16_min(_page_height, HEIGHT - page_ys), true);
           }
+          _waitWrite();
           epd2.refresh(true);
         }
       }
       _current_page = 0;
+      _resetDirty();
     }
 
     void drawInvertedBitmap(int16_t x, int16_t y, const uint8_t bitmap[], int16_t w, int16_t h, uint16_t color)
     {
-      // taken from Adafruit_GFX.cpp, modified
-      int16_t byteWidth = (w + 7) / 8; // Bitmap scanline pad = whole byte
-      uint8_t byte = 0;
-      for (int16_t j = 0; j < h; j++)
+      _drawBitmap(bitmap, x, y, w, h, color, true, true);
+    }
+
+    // Adafruit_GFX drawBitmap variants, bitmap in program memory or in RAM, through the byte-wise blitter
+    void drawBitmap(int16_t x, int16_t y, const uint8_t bitmap[], int16_t w, int16_t h, uint16_t color)
+    {
+      _drawBitmap(bitmap, x, y, w, h, color, false, true);
+    }
+
+    void drawBitmap(int16_t x, int16_t y, const uint8_t bitmap[], int16_t w, int16_t h, uint16_t color, uint16_t bg)
+    {
+      _drawBitmap(bitmap, x, y, w, h, color, false, true);
+      _drawBitmap(bitmap, x, y, w, h, bg, true, true);
+    }
+
+    void drawBitmap(int16_t x, int16_t y, uint8_t* bitmap, int16_t w, int16_t h, uint16_t color)
+    {
+      _drawBitmap(bitmap, x, y, w, h, color, false, false);
+    }
+
+    void drawBitmap(int16_t x, int16_t y, uint8_t* bitmap, int16_t w, int16_t h, uint16_t color, uint16_t bg)
+    {
+      _drawBitmap(bitmap, x, y, w, h, color, false, false);
+      _drawBitmap(bitmap, x, y, w, h, bg, true, false);
+    }
+
+    // current page in display coordinates (rotation and mirror applied), for culling in paged drawing
+    void getPageBounds(int16_t& x, int16_t& y, int16_t& w, int16_t& h)
+    {
+      uint16_t bx = _pw_x;
+      uint16_t by = _pw_y + _current_page * _page_height;
+      uint16_t bw = _pw_w;
+      uint16_t bh = by < _pw_y + _pw_h ? gx_uint16_min(_page_height, _pw_y + _pw_h - by) : 0;
+      switch (_rotation())
       {
-        for (int16_t i = 0; i < w; i++ )
-        {
-          if (i & 7) byte <<= 1;
-          else
-          {
-#if defined(__AVR) || defined(ESP8266) || defined(ESP32)
-            byte = pgm_read_byte(&bitmap[j * byteWidth + i / 8]);
-#else
-            byte = bitmap[j * byteWidth + i / 8];
-#endif
-          }
-          if (!(byte & 0x80))
-          {
-            drawPixel(x + i, y + j, color);
-          }
-        }
+        case 1:
+          x = by;
+          y = WIDTH - bx - bw;
+          w = bh;
+          h = bw;
+          break;
+        case 2:
+          x = WIDTH - bx - bw;
+          y = HEIGHT - by - bh;
+          w = bw;
+          h = bh;
+          break;
+        case 3:
+          x = HEIGHT - by - bh;
+          y = bx;
+          w = bh;
+          h = bw;
+          break;
+        default:
+          x = bx;
+          y = by;
+          w = bw;
+          h = bh;
+      }
+      if (_mirrored()) x = _displayWidth() - x - w;
+    }
+
+    // false if rectangle x, y, w, h (display coordinates) misses the current page, nothing to draw
+    bool intersectsPage(int16_t x, int16_t y, int16_t w, int16_t h)
+    {
+      int16_t px, py, pw, ph;
+      getPageBounds(px, py, pw, ph);
+      return (x < px + pw) && (px < int32_t(x) + w) && (y < py + ph) && (py < int32_t(y) + h);
+    }
+
+    // lines missing the current page are skipped
+    void drawLine(int16_t x0, int16_t y0, int16_t x1, int16_t y1, uint16_t color)
+    {
+      int16_t x = x0 < x1 ? x0 : x1;
+      int16_t y = y0 < y1 ? y0 : y1;
+      if (!intersectsPage(x, y, abs(x1 - x0) + 1, abs(y1 - y0) + 1)) return;
+      Adafruit_GFX::drawLine(x0, y0, x1, y1, color);
+    }
+
+    // text glyphs missing the current page only advance the cursor
+    size_t write(uint8_t c)
+    {
+      GxEPD2_GlyphCache::Placement p;
+      if (!GxEPD2_GlyphCache::place(*this, gfxFont, c, p)) return Adafruit_GFX::write(c);
+      if (intersectsPage(p.x, p.y, p.w, p.h))
+      {
+        const uint8_t* glyph = _glyph_cache && gfxFont && p.size1 ? _glyph_cache->get(gfxFont, c) : 0;
+        if (!glyph) return Adafruit_GFX::write(c);
+        _drawBitmap(glyph, p.x, p.y, p.w, p.h, textcolor, false, false);
       }
+      setCursor(p.cursor_x, p.cursor_y);
+      return 1;
     }
 
     //  Support for Bitmaps (Sprites) to Controller Buffer and to Screen
     void clearScreen(uint8_t value = 0xFF) // init controller memory and screen (default white)
     {
+      _invalidateRowHashes();
       epd2.clearScreen(value);
     }
     void writeScreenBuffer(uint8_t value = 0xFF) // init controller memory (default white)
     {
+      _invalidateRowHashes();
       epd2.writeScreenBuffer(value);
     }
     // write to controller memory, without screen refresh; x and w should be multiple of 8
     void writeImage(const uint8_t bitmap[], int16_t x, int16_t y, int16_t w, int16_t h, bool invert = false, bool mirror_y = false, bool pgm = false)
     {
+      _invalidateRowHashes();
       epd2.writeImage(bitmap, x, y, w, h, invert, mirror_y, pgm);
     }
     void writeImage(const uint8_t* black, const uint8_t* color, int16_t x, int16_t y, int16_t w, int16_t h, bool invert = false, bool mirror_y = false, bool pgm = false)
     {
+      _invalidateRowHashes();
       epd2.writeImage(black, color, x, y, w, h, invert, mirror_y, pgm);
     }
     // write sprite of native data to controller memory, without screen refresh; x and w should be multiple of 8
     void writeNative(const uint8_t* data1, const uint8_t* data2, int16_t x, int16_t y, int16_t w, int16_t h, bool invert, bool mirror_y, bool pgm)
     {
+      _invalidateRowHashes();
       epd2.writeNative(data1, data2, x, y, w, h, invert, mirror_y, pgm);
     }
     // write to controller memory, with screen refresh; x and w should be multiple of 8
     void drawImage(const uint8_t bitmap[], int16_t x, int16_t y, int16_t w, int16_t h, bool invert = false, bool mirror_y = false, bool pgm = false)
     {
+      _invalidateRowHashes();
       epd2.drawImage(bitmap, x, y, w, h, invert, mirror_y, pgm);
     }
     void drawImage(const uint8_t* black, const uint8_t* color, int16_t x, int16_t y, int16_t w, int16_t h, bool invert = false, bool mirror_y = false, bool pgm = false)
     {
+      _invalidateRowHashes();
       epd2.drawImage(black, color, x, y, w, h, invert, mirror_y, pgm);
     }
     // write sprite of native data to controller memory, with screen refresh; x and w should be multiple of 8
     void drawNative(const uint8_t* data1, const uint8_t* data2, int16_t x, int16_t y, int16_t w, int16_t h, bool invert, bool mirror_y, bool pgm)
     {
+      _invalidateRowHashes();
       epd2.drawNative(data1, data2, x, y, w, h, invert, mirror_y, pgm);
     }
     void refresh(bool partial_update_mode = false) // screen refresh from controller memory to full screen
     {
-      epd2.refresh(partial_update_mode);
+      _refresh(partial_update_mode);
     }
     void refresh(int16_t x, int16_t y, int16_t w, int16_t h) // screen refresh from controller memory, partial screen
     {
-      epd2.refresh(x, y, w, h);
+      _refresh(x, y, w, h);
     }
     void powerOff()
     {
@@ -359,9 +765,54 @@ class GxEPD2_BW : public Adafruit_GFX
     {
       return (a > b ? a : b);
     };
+    void _setPageBuffer(uint8_t* buffer, uint32_t buffer_size)
+    {
+      uint32_t rows = buffer ? buffer_size / (GxEPD2_Type::WIDTH / 8) : 0;
+      if (rows == 0)
+      {
+        buffer = _page_buffer;
+        rows = page_height;
+      }
+      _page_height = rows < uint32_t(GxEPD2_Type::HEIGHT) ? rows : GxEPD2_Type::HEIGHT;
+      _pages = (HEIGHT / _page_height) + ((HEIGHT % _page_height) > 0);
+      _buffer_size = uint32_t(GxEPD2_Type::WIDTH / 8) * _page_height;
+      _buffer = buffer;
+      _buffer_base = buffer;
+    }
+    // page height and number of pages for the current window; a narrow partial window uses the whole buffer for taller pages
+    void _planPages()
+    {
+      uint16_t wb = gx_uint16_max(_pw_w / 8, 1);
+      uint16_t h = gx_uint16_max(_pw_h, 1);
+      uint32_t rows = (_ping_pong ? _buffer_size / 2 : _buffer_size) / wb;
+      _page_height = rows < h ? rows : h;
+      _pages = (h / _page_height) + ((h % _page_height) > 0);
+    }
+    // buffer bytes of a page of the current window
+    uint32_t _usedBytes()
+    {
+      return uint32_t(_page_height) * (_pw_w / 8);
+    }
+    // constants for a fixed rotation, folded by the compiler
+    uint8_t _rotation()
+    {
+      return fixed_rotation < 0 ? getRotation() : fixed_rotation;
+    }
+    bool _mirrored()
+    {
+      return fixed_rotation < 0 ? _mirror : fixed_mirror;
+    }
+    int16_t _displayWidth()
+    {
+      return fixed_rotation < 0 ? width() : (fixed_rotation & 1 ? int16_t(GxEPD2_Type::HEIGHT) : int16_t(GxEPD2_Type::WIDTH));
+    }
+    int16_t _displayHeight()
+    {
+      return fixed_rotation < 0 ? height() : (fixed_rotation & 1 ? int16_t(GxEPD2_Type::WIDTH) : int16_t(GxEPD2_Type::HEIGHT));
+    }
     void _rotate(uint16_t& x, uint16_t& y, uint16_t& w, uint16_t& h)
     {
-      switch (getRotation())
+      switch (_rotation())
       {
         case 1:
           swap(x, y);
@@ -379,13 +830,511 @@ class GxEPD2_BW : public Adafruit_GFX
           break;
       }
     }
+    // display rectangle to buffer rectangle of the current page, clipped; false if empty
+    bool _clipRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t& bx, uint16_t& by, uint16_t& bw, uint16_t& bh)
+    {
+      if (w < 0)
+      {
+        x += w + 1;
+        w = -w;
+      }
+      if (h < 0)
+      {
+        y += h + 1;
+        h = -h;
+      }
+      int32_t x1 = x < 0 ? 0 : x;
+      int32_t y1 = y < 0 ? 0 : y;
+      int32_t x2 = int32_t(x) + w < _displayWidth() ? int32_t(x) + w : _displayWidth(); // exclusive
+      int32_t y2 = int32_t(y) + h < _displayHeight() ? int32_t(y) + h : _displayHeight(); // exclusive
+      if ((x2 <= x1) || (y2 <= y1)) return false;
+      if (_mirrored())
+      {
+        int32_t t = x1;
+        x1 = _displayWidth() - x2;
+        x2 = _displayWidth() - t;
+      }
+      uint16_t rx = x1, ry = y1, rw = x2 - x1, rh = y2 - y1;
+      _rotate(rx, ry, rw, rh);
+      // transpose partial window to 0,0 and adjust for current page
+      x1 = int32_t(rx) - _pw_x;
+      y1 = int32_t(ry) - _pw_y - int32_t(_current_page) * _page_height;
+      x2 = x1 + rw;
+      y2 = y1 + rh;
+      if (x1 < 0) x1 = 0;
+      if (y1 < 0) y1 = 0;
+      if (x2 > _pw_w) x2 = _pw_w;
+      if (y2 > _page_height) y2 = _page_height;
+      if ((x2 <= x1) || (y2 <= y1)) return false;
+      bx = x1;
+      by = y1;
+      bw = x2 - x1;
+      bh = y2 - y1;
+      return true;
+    }
+    // combine buffer rectangle with value by op (GxEPD2::RasterOp), edge bytes masked; returns true if content changed
+    bool _ropRect(uint8_t* buffer, uint16_t x, uint16_t y, uint16_t w, uint16_t h, uint8_t value, uint8_t op)
+    {
+      uint16_t wb = _pw_w / 8;
+      int32_t first = -1, last = -1; // changed bytes
+      if ((x == 0) && (w == _pw_w))
+      {
+        // full rows are contiguous
+        _ropSpan(buffer, uint32_t(y) * wb, uint32_t(h) * wb, value, op, first, last);
+        return first >= 0;
+      }
+      uint16_t xb1 = x / 8;
+      uint16_t xb2 = (x + w - 1) / 8;
+      uint8_t mask1 = 0xFF >> (x % 8);
+      uint8_t mask2 = 0xFF << (7 - (x + w - 1) % 8);
+      if (xb1 == xb2) mask1 &= mask2;
+      for (uint16_t i = y; i < y + h; i++)
+      {
+        uint32_t row = uint32_t(i) * wb;
+        _ropByte(buffer, row + xb1, value, mask1, op, first, last);
+        if (xb2 == xb1) continue;
+        _ropSpan(buffer, row + xb1 + 1, xb2 - xb1 - 1, value, op, first, last);
+        _ropByte(buffer, row + xb2, value, mask2, op, first, last);
+      }
+      return first >= 0;
+    }
+    // combine n buffer bytes from start with value, 32 bits at a time where aligned; changed bytes extend first, last
+    static void _ropSpan(uint8_t* buffer, uint32_t start, uint32_t n, uint8_t value, uint8_t op, int32_t& first, int32_t& last)
+    {
+      uint32_t i = start;
+      uint32_t end = start + n;
+      for (; (i < end) && (uintptr_t(buffer + i) % 4 != 0); i++) _ropByte(buffer, i, value, 0xFF, op, first, last);
+      uint32_t value32 = value * 0x01010101UL;
+      for (; i + 4 <= end; i += 4)
+      {
+        uint32_t data, result;
+        memcpy(&data, buffer + i, 4);
+        switch (op)
+        {
+          case GxEPD2::RopOr: result = data | value32; break;
+          case GxEPD2::RopAnd: result = data & value32; break;
+          case GxEPD2::RopXor: result = data ^ value32; break;
+          default: result = value32;
+        }
+        if (result == data) continue;
+        memcpy(buffer + i, &result, 4);
+        if (first < 0) first = i;
+        last = i + 3;
+      }
+      for (; i < end; i++) _ropByte(buffer, i, value, 0xFF, op, first, last);
+    }
+    static void _ropByte(uint8_t* buffer, uint32_t i, uint8_t value, uint8_t mask, uint8_t op, int32_t& first, int32_t& last)
+    {
+      uint8_t data = buffer[i];
+      uint8_t result = (data & ~mask) | (_rop(data, value, op) & mask);
+      if (result == data) return;
+      buffer[i] = result;
+      if (first < 0) first = i;
+      last = i;
+    }
+    static uint8_t _rop(uint8_t data, uint8_t value, uint8_t op)
+    {
+      switch (op)
+      {
+        case GxEPD2::RopOr: return data | value;
+        case GxEPD2::RopAnd: return data & value;
+        case GxEPD2::RopXor: return data ^ value;
+      }
+      return value;
+    }
+    // buffer position of display pixel x, y, not clipped
+    void _bufferPosition(int16_t x, int16_t y, int32_t& bx, int32_t& by)
+    {
+      int32_t dx = _mirrored() ? _displayWidth() - x - 1 : x;
+      int32_t dy = y;
+      switch (_rotation())
+      {
+        case 1:
+          bx = WIDTH - dy - 1;
+          by = dx;
+          break;
+        case 2:
+          bx = WIDTH - dx - 1;
+          by = HEIGHT - dy - 1;
+          break;
+        case 3:
+          bx = dy;
+          by = HEIGHT - dx - 1;
+          break;
+        default:
+          bx = dx;
+          by = dy;
+      }
+      bx -= _pw_x;
+      by -= _pw_y + int32_t(_current_page) * _page_height;
+    }
+    // draw pixels of set bits (invert: clear bits) with color combined by op; clipped once, then shifted and masked into the buffer bytewise
+    void _drawBitmap(const uint8_t* bitmap, int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color, bool invert, bool pgm, uint8_t op = GxEPD2::RopCopy)
+    {
+      uint16_t bx, by, bw, bh;
+      if ((w <= 0) || (h <= 0) || !_clipRect(x, y, w, h, bx, by, bw, bh)) return;
+      // buffer position of bitmap pixel i, j is o + i * u + j * v
+      int32_t ox, oy, ux, uy, vx, vy;
+      _bufferPosition(x, y, ox, oy);
+      _bufferPosition(x + 1, y, ux, uy);
+      _bufferPosition(x, y + 1, vx, vy);
+      ux -= ox;
+      uy -= oy;
+      vx -= ox;
+      vy -= oy;
+      uint16_t wb = (w + 7) / 8; // bitmap scanline pad = whole byte
+      uint16_t dwb = _pw_w / 8;
+      uint8_t flip = invert ? 0xFF : 0x00;
+      uint8_t value = color ? 0xFF : 0x00;
+      bool changed = false;
+      for (uint16_t row = by; row < by + bh; row++)
+      {
+        for (uint16_t k = bx / 8; k <= (bx + bw - 1) / 8; k++)
+        {
+          uint16_t x1 = gx_uint16_max(k * 8, bx);
+          uint16_t x2 = gx_uint16_min(k * 8 + 8, bx + bw);
+          uint8_t mask = (0xFF >> (x1 - k * 8)) & (0xFF << (k * 8 + 8 - x2));
+          uint8_t bits = 0;
+          if (ux != 0)
+          {
+            // bitmap row to buffer row, forward or mirrored
+            const uint8_t* src = bitmap + uint32_t((int32_t(row) - oy) / vy) * wb;
+            int32_t i = (int32_t(k) * 8 - ox) * ux; // bitmap pixel of the first buffer pixel of this byte
+            if (ux > 0) bits = _bitmapBits(src, i, wb, pgm);
+            else bits = _reverseBits(_bitmapBits(src, i - 7, wb, pgm));
+          }
+          else
+          {
+            // bitmap column to buffer row, rotation 1 and 3
+            int32_t i = (int32_t(row) - oy) / uy;
+            for (uint16_t p = x1; p < x2; p++)
+            {
+              uint32_t j = (int32_t(p) - ox) / vx;
+              if (_bitmapByte(bitmap, j * wb + i / 8, pgm) & (0x80 >> (i % 8))) bits |= 0x80 >> (p % 8);
+            }
+          }
+          mask &= bits ^ flip;
+          if (!mask) continue;
+          uint32_t n = uint32_t(row) * dwb + k;
+          uint8_t data = (_buffer[n] & ~mask) | (_rop(_buffer[n], value, op) & mask);
+          if (data == _buffer[n]) continue;
+          _buffer[n] = data;
+          changed = true;
+        }
+      }
+      if (changed) _setDirty(bx, by, bx + bw - 1, by + bh - 1);
+    }
+    // copy controller rows of the current page from a WIDTH x HEIGHT bitmap (NULL: white), white outside window
+    void _copyBackground(uint8_t* buffer, const uint8_t* bitmap)
+    {
+      uint16_t wb = _pw_w / 8;
+      uint16_t ys = _pw_y + _current_page * _page_height;
+      int32_t first = -1, last = -1; // changed bytes
+      for (uint16_t i = 0; i < _page_height; i++)
+      {
+        bool inside = bitmap && (ys + i < _pw_y + _pw_h);
+        uint32_t src = uint32_t(ys + i) * (WIDTH / 8) + _pw_x / 8;
+        for (uint16_t j = 0; j < wb; j++)
+        {
+          uint32_t n = uint32_t(i) * wb + j;
+          uint8_t data = inside ? _bitmapByte(bitmap, src + j, _background_pgm) : 0xFF;
+          if (buffer[n] == data) continue;
+          buffer[n] = data;
+          if (first < 0) first = n;
+          last = n;
+        }
+      }
+      if (first >= 0) _setDirtyBytes(first, last);
+    }
+    static uint8_t _bitmapByte(const uint8_t* bitmap, uint32_t idx, bool pgm)
+    {
+#if defined(__AVR) || defined(ESP8266) || defined(ESP32)
+      if (pgm) return pgm_read_byte(&bitmap[idx]);
+#endif
+      return bitmap[idx];
+    }
+    // 8 bits of a bitmap scanline starting at pixel i, i >= -7; pixels outside the scanline read as 0
+    static uint8_t _bitmapBits(const uint8_t* row, int32_t i, uint16_t wb, bool pgm)
+    {
+      int32_t b = (i + 8) / 8 - 1;
+      uint8_t shift = (i + 8) % 8;
+      uint8_t b0 = (b >= 0) && (b < wb) ? _bitmapByte(row, b, pgm) : 0;
+      if (shift == 0) return b0; // byte aligned
+      uint8_t b1 = (b + 1 >= 0) && (b + 1 < wb) ? _bitmapByte(row, b + 1, pgm) : 0;
+      return (b0 << shift) | (b1 >> (8 - shift));
+    }
+    static uint8_t _reverseBits(uint8_t b)
+    {
+      b = ((b & 0xF0) >> 4) | ((b & 0x0F) << 4);
+      b = ((b & 0xCC) >> 2) | ((b & 0x33) << 2);
+      return ((b & 0xAA) >> 1) | ((b & 0x55) << 1);
+    }
+    // write buffer rows to controller memory; with row hash table only rows with changed content are written
+    // commit false: controller memory gets written again afterwards (second phase), keep the old hashes
+    // dual: write previous and current image memory of the controller, see hasDualRamWrite
+    // write the current page; with ping-pong buffers the writer task does it, after the previous page is written
+    void _writePage(uint16_t x, uint16_t y, uint16_t w, uint16_t h, bool commit, bool dual = false)
+    {
+#if defined(ESP32)
+      if (_ping_pong)
+      {
+        xSemaphoreTake(_write_done, portMAX_DELAY);
+        _write_job.buffer = _buffer;
+        _write_job.x = x;
+        _write_job.y = y;
+        _write_job.w = w;
+        _write_job.h = h;
+        _write_job.commit = commit;
+        _write_job.dual = dual;
+        xSemaphoreGive(_write_request);
+        return;
+      }
+#endif
+      _writeImage(_buffer, x, y, w, h, commit, dual);
+    }
+    // wait until the last page is written, before other controller access
+    void _waitWrite()
+    {
+#if defined(ESP32)
+      if (!_ping_pong) return;
+      xSemaphoreTake(_write_done, portMAX_DELAY);
+      xSemaphoreGive(_write_done);
+#endif
+    }
+    // draw the next page into the other buffer; it is free, its write was waited for by _writePage()
+    void _swapPageBuffer()
+    {
+      if (!_ping_pong) return;
+      _buffer = _buffer == _buffer_base ? _buffer_base + _buffer_size / 2 : _buffer_base;
+    }
+#if defined(ESP32)
+    // the writer task and its semaphores exist while ping-pong buffers are enabled
+    void _deleteWriter()
+    {
+      if (_writer) vTaskDelete(_writer);
+      if (_write_request) vSemaphoreDelete(_write_request);
+      if (_write_done) vSemaphoreDelete(_write_done);
+      _writer = 0;
+      _write_request = 0;
+      _write_done = 0;
+    }
+    static void _writeTask(void* pv)
+    {
+      GxEPD2_BW* display = (GxEPD2_BW*)pv;
+      SemaphoreHandle_t request = display->_write_request, done = display->_write_done; // set before the task is created
+      for (;;)
+      {
+        xSemaphoreTake(request, portMAX_DELAY);
+        WriteJob& job = display->_write_job;
+        display->_writeImage(job.buffer, job.x, job.y, job.w, job.h, job.commit, job.dual);
+        xSemaphoreGive(done);
+      }
+    }
+#endif
+    void _writeImage(const uint8_t* buffer, uint16_t x, uint16_t y, uint16_t w, uint16_t h, bool commit, bool dual = false)
+    {
+      if (!_row_hash)
+      {
+        _writeRows(buffer, x, y, w, h, dual);
+        return;
+      }
+      uint16_t wb = w / 8;
+      int16_t run_start = -1; // first buffer row of current run of changed rows
+      for (uint16_t i = 0; i <= h; i++)
+      {
+        bool changed = false;
+        if (i < h)
+        {
+          uint32_t hash = _rowHash(buffer + uint32_t(i) * wb, x, wb);
+          changed = (_row_hash[y + i] != hash);
+          if (commit) _row_hash[y + i] = hash;
+        }
+        if (changed && (run_start < 0)) run_start = i;
+        else if (!changed && (run_start >= 0))
+        {
+          _writeRows(buffer + uint32_t(run_start) * wb, x, y + run_start, w, i - run_start, dual);
+          run_start = -1;
+        }
+      }
+    }
+    // writeImageDual() is only declared by drivers with hasDualRamWrite, select at compile time
+    template <bool> struct DualRamWrite {};
+    void _writeRows(const uint8_t* buffer, uint16_t x, uint16_t y, uint16_t w, uint16_t h, bool dual)
+    {
+      if (dual) _writeRows(buffer, x, y, w, h, DualRamWrite<GxEPD2_Type::hasDualRamWrite>());
+      else epd2.writeImage(buffer, x, y, w, h);
+    }
+    void _writeRows(const uint8_t* buffer, uint16_t x, uint16_t y, uint16_t w, uint16_t h, DualRamWrite<true>)
+    {
+      epd2.writeImageDual(buffer, x, y, w, h);
+    }
+    void _writeRows(const uint8_t* buffer, uint16_t x, uint16_t y, uint16_t w, uint16_t h, DualRamWrite<false>)
+    {
+      epd2.writeImage(buffer, x, y, w, h);
+    }
+    static uint32_t _rowHash(const uint8_t* data, uint16_t x, uint16_t wb)
+    {
+      // FNV-1a, includes position, 0 is reserved for unknown content
+      uint32_t hash = 2166136261UL;
+      hash = (hash ^ (x / 8)) * 16777619UL;
+      hash = (hash ^ wb) * 16777619UL;
+      for (uint16_t j = 0; j < wb; j++)
+      {
+        hash = (hash ^ data[j]) * 16777619UL;
+      }
+      return hash ? hash : 1;
+    }
+    // write buffer rows of window width for controller rows ys to ye inclusive
+    void _writeRows(uint16_t ys, uint16_t ye, bool commit)
+    {
+      uint32_t offset = uint32_t(ys - _pw_y) * (_pw_w / 8);
+      _writeImage(_buffer + offset, _pw_x, ys, _pw_w, ye - ys + 1, commit);
+    }
+    // write the union of the buffer rows of the planned regions
+    void _writeRegionRows(GxEPD2_RefreshPlanner<GxEPD2_Type>& planner, bool commit)
+    {
+      uint16_t ys = 0; // next row not yet written
+      while (true)
+      {
+        // lowest region start at or after ys, extended by all regions overlapping the run
+        int32_t run_ys = -1, run_ye = -1;
+        for (uint8_t i = 0; i < planner.regions(); i++)
+        {
+          const GxEPD2_Region& r = planner.region(i);
+          if (r.y + r.h <= ys) continue;
+          uint16_t s = gx_uint16_max(r.y, ys);
+          if ((run_ys < 0) || (s < run_ys)) run_ys = s;
+        }
+        if (run_ys < 0) break;
+        run_ye = run_ys;
+        for (bool extended = true; extended;)
+        {
+          extended = false;
+          for (uint8_t i = 0; i < planner.regions(); i++)
+          {
+            const GxEPD2_Region& r = planner.region(i);
+            if ((r.y <= run_ye + 1) && (r.y + r.h - 1 > run_ye))
+            {
+              run_ye = r.y + r.h - 1;
+              extended = true;
+            }
+          }
+        }
+        _writeRows(run_ys, run_ye, commit);
+        ys = run_ye + 1;
+      }
+    }
+    // screen refresh through the refresh policy, if attached
+    void _refresh(bool partial_update_mode)
+    {
+      if (partial_update_mode && !(_policy && _policy->partialRefresh(0, 0, WIDTH, HEIGHT))) epd2.refresh(true);
+      else
+      {
+        epd2.refresh(false);
+        if (_policy) _policy->fullRefresh();
+      }
+    }
+    void _refresh(int16_t x, int16_t y, int16_t w, int16_t h)
+    {
+      if (_policy && _policy->partialRefresh(x, y, w, h)) _refresh(false);
+      else epd2.refresh(x, y, w, h);
+    }
+    void _refresh(GxEPD2_RefreshPlanner<GxEPD2_Type>& planner)
+    {
+      if (planner.isFullRefresh()) _refresh(false);
+      else
+      {
+        for (uint8_t i = 0; i < planner.regions(); i++)
+        {
+          const GxEPD2_Region& r = planner.region(i);
+          _refresh(r.x, r.y, r.w, r.h);
+        }
+      }
+    }
+    // partial windows, separate or merged refreshes, whichever is estimated faster
+    void _refreshWindows()
+    {
+      if (_window_count == 1) _refresh(_pw_x, _pw_y, _pw_w, _pw_h);
+      else
+      {
+        GxEPD2_RefreshPlanner<GxEPD2_Type> planner;
+        for (uint8_t i = 0; i < _window_count; i++)
+        {
+          planner.add(_windows[i].x, _windows[i].y, _windows[i].w, _windows[i].h);
+        }
+        planner.plan(false);
+        _refresh(planner);
+      }
+    }
+    void _selectWindow(uint8_t i)
+    {
+      _current_window = i;
+      _pw_x = _windows[i].x;
+      _pw_y = _windows[i].y;
+      _pw_w = _windows[i].w;
+      _pw_h = _windows[i].h;
+      _planPages();
+    }
+    void _setDirty(uint16_t x1, uint16_t y1, uint16_t x2, uint16_t y2)
+    {
+      if (x1 < _dirty_x1) _dirty_x1 = x1;
+      if (y1 < _dirty_y1) _dirty_y1 = y1;
+      if (x2 > _dirty_x2) _dirty_x2 = x2;
+      if (y2 > _dirty_y2) _dirty_y2 = y2;
+    }
+    void _setDirtyBytes(uint32_t first, uint32_t last)
+    {
+      uint16_t wb = _pw_w / 8;
+      uint16_t y1 = first / wb;
+      uint16_t y2 = last / wb;
+      if (y1 == y2) _setDirty((first % wb) * 8, y1, (last % wb) * 8 + 7, y2);
+      else _setDirty(0, y1, _pw_w - 1, y2);
+    }
+    void _resetDirty()
+    {
+      _dirty_x1 = _dirty_y1 = 0xFFFF;
+      _dirty_x2 = _dirty_y2 = 0;
+    }
+    void _invalidateRowHashes()
+    {
+      if (!_row_hash) return;
+      for (uint16_t i = 0; i < HEIGHT; i++)
+      {
+        _row_hash[i] = 0;
+      }
+    }
   private:
-    uint8_t _buffer[(GxEPD2_Type::WIDTH / 8) * page_height];
-    bool _using_partial_mode, _second_phase, _mirror, _reverse;
+    uint8_t _page_buffer[(GxEPD2_Type::WIDTH / 8) * page_height];
+    uint8_t* _buffer;
+    uint8_t* _buffer_base; // _buffer is one of its halves with ping-pong buffers
+    uint32_t _buffer_size;
+    bool _using_partial_mode, _second_phase, _mirror;
     uint16_t _width_bytes, _pixel_bytes;
     int16_t _current_page;
     uint16_t _pages, _page_height;
     uint16_t _pw_x, _pw_y, _pw_w, _pw_h;
+    GxEPD2_Region _windows[max_partial_windows]; // controller coordinates
+    uint8_t _window_count, _current_window;
+    uint32_t* _row_hash;
+    uint16_t _dirty_x1, _dirty_y1, _dirty_x2, _dirty_y2; // changed region in buffer coordinates, inclusive
+    GxEPD2_RefreshPolicy* _policy;
+    GxEPD2_GlyphCache* _glyph_cache;
+    const uint8_t* _background;
+    bool _background_pgm;
+    void (*_background_callback)(const void*);
+    const void* _background_pv;
+    bool _ping_pong;
+#if defined(ESP32)
+    struct WriteJob
+    {
+      const uint8_t* buffer;
+      uint16_t x, y, w, h;
+      bool commit, dual;
+    };
+    WriteJob _write_job;
+    TaskHandle_t _writer;
+    SemaphoreHandle_t _write_request, _write_done;
+#endif
 };
 
 #endif
@@ -0,0 +1,416 @@
+// Display Library for SPI e-paper panels from Dalian Good Display and boards from Waveshare.
+// Requires HW SPI and Adafruit_GFX. Caution: these e-papers require 3.3V supply AND data lines!
+//
+// based on Demo Example from Good Display: http://www.good-display.com/download_list/downloadcategoryid=34&isMode=false.html
+//
+// Author: Jean-Marc Zingg
+//
+// Version: see library.properties
+//
+// Library: https://github.com/ZinggJM/GxEPD2
+
+#ifndef _GxEPD2_BW_RLE_H_
+#define _GxEPD2_BW_RLE_H_
+
+#include <Adafruit_GFX.h>
+#include "GxEPD2_EPD.h"
+#include "epd/GxEPD2_154.h"
+#include "epd/GxEPD2_213.h"
+#include "epd/GxEPD2_290.h"
+#include "epd/GxEPD2_270.h"
+#include "epd/GxEPD2_420.h"
+#include "epd/GxEPD2_583.h"
+#include "epd/GxEPD2_750.h"
+
+// b/w full screen buffer, run length encoded per row, for MCUs without RAM for a full frame
+// the compressed rows are kept in an arena provided by the application, with free space as a gap at the last edited row
+// drawing edits rows decompressed in a cache of cache_rows rows; display() streams the rows to controller memory
+// mostly white screens with text need a fraction of the full frame size; overflow() tells if the arena was too small
+// the arena also holds the row index, 2 bytes per row; the row cache of cache_rows * WIDTH / 8 bytes is part of the instance
+template<typename GxEPD2_Type, const uint8_t cache_rows = 8>
+class GxEPD2_BW_RLE : public Adafruit_GFX
+{
+  public:
+    GxEPD2_Type epd2;
+    GxEPD2_BW_RLE(GxEPD2_Type epd2_instance, uint8_t* arena, uint16_t arena_size) :
+      Adafruit_GFX(GxEPD2_Type::WIDTH, GxEPD2_Type::HEIGHT), epd2(epd2_instance)
+    {
+      // arena : row index, then the compressed rows
+      uint16_t pad = uintptr_t(arena) % 2;
+      uint16_t index = pad + HEIGHT * sizeof(uint16_t);
+      _offset = (uint16_t*)(arena + pad);
+      _arena = arena + index;
+      _size = arena_size > index ? arena_size - index : 0;
+      _gap_row = HEIGHT;
+      _gap_start = 0;
+      _gap_end = _size;
+      _mirror = false;
+      _ready = false;
+      fillScreen(GxEPD_WHITE);
+    }
+
+    bool mirror(bool m)
+    {
+      swap (_mirror, m);
+      return m;
+    }
+
+    void drawPixel(int16_t x, int16_t y, uint16_t color)
+    {
+      if ((x < 0) || (x >= width()) || (y < 0) || (y >= height())) return;
+      if (_mirror) x = width() - x - 1;
+      // check rotation, move pixel around if necessary
+      switch (getRotation())
+      {
+        case 1:
+          swap(x, y);
+          x = WIDTH - x - 1;
+          break;
+        case 2:
+          x = WIDTH - x - 1;
+          y = HEIGHT - y - 1;
+          break;
+        case 3:
+          swap(x, y);
+          y = HEIGHT - y - 1;
+          break;
+      }
+      uint8_t* row = _row(y, false);
+      if (!row) return;
+      uint8_t data = row[x / 8];
+      if (color)
+        data = (data | (1 << (7 - x % 8)));
+      else
+        data = (data & (0xFF ^ (1 << (7 - x % 8))));
+      if (row[x / 8] == data) return;
+      row[x / 8] = data;
+      _cache_dirty[_slot] = true;
+    }
+
+    void init(uint32_t serial_diag_bitrate = 0) // = 0 : disabled
+    {
+      epd2.init(serial_diag_bitrate);
+    }
+
+    void fillScreen(uint16_t color) // 0x0 black, >0x0 white, to buffer
+    {
+      uint8_t row[GxEPD2_Type::WIDTH / 8];
+      memset(row, (color == GxEPD_BLACK) ? 0x00 : 0xFF, sizeof(row));
+      uint16_t n = _encode(row, 0);
+      if (uint32_t(n) * HEIGHT > _size)
+      {
+        _overflow = true;
+        return;
+      }
+      for (uint16_t y = 0; y < HEIGHT; y++)
+      {
+        _offset[y] = y * n;
+        _encode(row, _arena + _offset[y]);
+      }
+      _gap_row = HEIGHT;
+      _gap_start = HEIGHT * n;
+      _gap_end = _size;
+      for (uint8_t i = 0; i < cache_rows; i++)
+      {
+        _cache_y[i] = -1;
+      }
+      _slot = 0;
+      _cache_next = 0;
+      _overflow = false;
+      _ready = true;
+    }
+
+    void drawFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color)
+    {
+      fillRect(x, y, w, 1, color);
+    }
+
+    void drawFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color)
+    {
+      fillRect(x, y, 1, h, color);
+    }
+
+    // clipped once, then edited per row as whole bytes with edge masks; full rows are not decompressed
+    void fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color)
+    {
+      if (w < 0)
+      {
+        x += w + 1;
+        w = -w;
+      }
+      if (h < 0)
+      {
+        y += h + 1;
+        h = -h;
+      }
+      int16_t x1 = x < 0 ? 0 : x;
+      int16_t y1 = y < 0 ? 0 : y;
+      int16_t x2 = int32_t(x) + w < width() ? x + w : width(); // exclusive
+      int16_t y2 = int32_t(y) + h < height() ? y + h : height(); // exclusive
+      if ((x2 <= x1) || (y2 <= y1)) return;
+      if (_mirror)
+      {
+        int16_t t = x1;
+        x1 = width() - x2;
+        x2 = width() - t;
+      }
+      uint16_t rx = x1, ry = y1, rw = x2 - x1, rh = y2 - y1;
+      _rotate(rx, ry, rw, rh);
+      uint8_t value = color ? 0xFF : 0x00;
+      uint16_t xb1 = rx / 8;
+      uint16_t xb2 = (rx + rw - 1) / 8;
+      uint8_t mask1 = 0xFF >> (rx % 8);
+      uint8_t mask2 = 0xFF << (7 - (rx + rw - 1) % 8);
+      if (xb1 == xb2) mask1 &= mask2;
+      bool full_row = (rw == WIDTH);
+      for (uint16_t i = ry; i < ry + rh; i++)
+      {
+        uint8_t* row = _row(i, full_row);
+        if (!row) return;
+        uint8_t changed = full_row ? 0xFF : 0;
+        changed |= (row[xb1] ^ value) & mask1;
+        row[xb1] = (row[xb1] & ~mask1) | (value & mask1);
+        for (uint16_t j = xb1 + 1; j < xb2; j++)
+        {
+          changed |= row[j] ^ value;
+          row[j] = value;
+        }
+        if (xb2 > xb1)
+        {
+          changed |= (row[xb2] ^ value) & mask2;
+          row[xb2] = (row[xb2] & ~mask2) | (value & mask2);
+        }
+        if (changed) _cache_dirty[_slot] = true;
+      }
+    }
+
+    // display buffer content to screen, rows decompressed in bands of cache_rows rows
+    void display(bool partial_update_mode = false)
+    {
+      if (!_ready) return;
+      _flushCache();
+      uint8_t* band = _cache[0];
+      for (uint16_t y = 0; y < HEIGHT; y += cache_rows)
+      {
+        uint16_t rows = gx_uint16_min(cache_rows, HEIGHT - y);
+        for (uint16_t i = 0; i < rows; i++)
+        {
+          _decode(_arena + _offset[y + i], band + i * (WIDTH / 8));
+        }
+        epd2.writeImage(band, 0, y, WIDTH, rows);
+      }
+      epd2.refresh(partial_update_mode);
+    }
+
+    // true if an edited row did not fit into the arena and kept its previous content
+    bool overflow()
+    {
+      return _overflow;
+    }
+    // arena bytes used by the compressed rows
+    uint16_t used()
+    {
+      return _size - (_gap_end - _gap_start);
+    }
+
+    //  Support for Bitmaps (Sprites) to Controller Buffer and to Screen
+    void clearScreen(uint8_t value = 0xFF) // init controller memory and screen (default white)
+    {
+      epd2.clearScreen(value);
+    }
+    void writeScreenBuffer(uint8_t value = 0xFF) // init controller memory (default white)
+    {
+      epd2.writeScreenBuffer(value);
+    }
+    // write to controller memory, without screen refresh; x and w should be multiple of 8
+    void writeImage(const uint8_t bitmap[], int16_t x, int16_t y, int16_t w, int16_t h, bool invert = false, bool mirror_y = false, bool pgm = false)
+    {
+      epd2.writeImage(bitmap, x, y, w, h, invert, mirror_y, pgm);
+    }
+    // write to controller memory, with screen refresh; x and w should be multiple of 8
+    void drawImage(const uint8_t bitmap[], int16_t x, int16_t y, int16_t w, int16_t h, bool invert = false, bool mirror_y = false, bool pgm = false)
+    {
+      epd2.drawImage(bitmap, x, y, w, h, invert, mirror_y, pgm);
+    }
+    void refresh(bool partial_update_mode = false) // screen refresh from controller memory to full screen
+    {
+      epd2.refresh(partial_update_mode);
+    }
+    void refresh(int16_t x, int16_t y, int16_t w, int16_t h) // screen refresh from controller memory, partial screen
+    {
+      epd2.refresh(x, y, w, h);
+    }
+    void powerOff()
+    {
+      epd2.powerOff();
+    }
+  private:
+    template <typename T> static inline void
+    swap(T & a, T & b)
+    {
+      T t = a;
+      a = b;
+      b = t;
+    };
+    static inline uint16_t gx_uint16_min(uint16_t a, uint16_t b)
+    {
+      return (a < b ? a : b);
+    };
+    void _rotate(uint16_t& x, uint16_t& y, uint16_t& w, uint16_t& h)
+    {
+      switch (getRotation())
+      {
+        case 1:
+          swap(x, y);
+          swap(w, h);
+          x = WIDTH - x - w;
+          break;
+        case 2:
+          x = WIDTH - x - w;
+          y = HEIGHT - y - h;
+          break;
+        case 3:
+          swap(x, y);
+          swap(w, h);
+          y = HEIGHT - y - h;
+          break;
+      }
+    }
+    // decompressed row y in the row cache, written back when evicted; overwrite: content will be replaced, not decompressed
+    uint8_t* _row(uint16_t y, bool overwrite)
+    {
+      if (!_ready) return 0;
+      if (_cache_y[_slot] == int16_t(y)) return _cache[_slot];
+      for (uint8_t i = 0; i < cache_rows; i++)
+      {
+        if (_cache_y[i] == int16_t(y))
+        {
+          _slot = i;
+          return _cache[i];
+        }
+      }
+      _slot = _cache_next;
+      _cache_next = (_cache_next + 1) % cache_rows;
+      _flush(_slot);
+      if (!overwrite) _decode(_arena + _offset[y], _cache[_slot]);
+      _cache_y[_slot] = y;
+      _cache_dirty[_slot] = false;
+      return _cache[_slot];
+    }
+    // compress a changed cached row back into the arena, at the gap
+    void _flush(uint8_t slot)
+    {
+      if ((_cache_y[slot] < 0) || !_cache_dirty[slot]) return;
+      uint16_t y = _cache_y[slot];
+      _cache_dirty[slot] = false;
+      _moveGap(y + 1);
+      uint16_t n = _encode(_cache[slot], 0);
+      if (uint32_t(_offset[y]) + n > _gap_end)
+      {
+        _overflow = true; // row keeps its previous content
+        return;
+      }
+      _encode(_cache[slot], _arena + _offset[y]);
+      _gap_start = _offset[y] + n;
+    }
+    void _flushCache()
+    {
+      for (uint8_t i = 0; i < cache_rows; i++)
+      {
+        _flush(i);
+        _cache_y[i] = -1;
+      }
+    }
+    // rows below gap_row are stored at the start of the arena, the others at its end
+    void _moveGap(uint16_t gap_row)
+    {
+      uint16_t gap = _gap_end - _gap_start;
+      if (gap_row > _gap_row)
+      {
+        uint16_t end = gap_row < HEIGHT ? _offset[gap_row] : _size;
+        uint16_t n = end - _gap_end;
+        memmove(_arena + _gap_start, _arena + _gap_end, n);
+        for (uint16_t y = _gap_row; y < gap_row; y++)
+        {
+          _offset[y] -= gap;
+        }
+        _gap_start += n;
+        _gap_end += n;
+      }
+      else if (gap_row < _gap_row)
+      {
+        uint16_t n = _gap_start - _offset[gap_row];
+        memmove(_arena + _gap_end - n, _arena + _offset[gap_row], n);
+        for (uint16_t y = gap_row; y < _gap_row; y++)
+        {
+          _offset[y] += gap;
+        }
+        _gap_start -= n;
+        _gap_end -= n;
+      }
+      _gap_row = gap_row;
+    }
+    // n < 0x80 : n + 1 bytes follow; n >= 0x80 : next byte repeated n - 0x7F times; returns size, out NULL : size only
+    static uint16_t _encode(const uint8_t* row, uint8_t* out)
+    {
+      const uint16_t wb = GxEPD2_Type::WIDTH / 8;
+      uint16_t size = 0;
+      for (uint16_t i = 0; i < wb;)
+      {
+        uint16_t run = 1;
+        while ((i + run < wb) && (run < 128) && (row[i + run] == row[i])) run++;
+        if (run >= 2)
+        {
+          if (out)
+          {
+            out[size] = 0x7F + run;
+            out[size + 1] = row[i];
+          }
+          size += 2;
+          i += run;
+          continue;
+        }
+        uint16_t literal = 1; // up to the next run of 2
+        while ((i + literal < wb) && (literal < 128) && !((i + literal + 1 < wb) && (row[i + literal] == row[i + literal + 1]))) literal++;
+        if (out)
+        {
+          out[size] = literal - 1;
+          memcpy(out + size + 1, row + i, literal);
+        }
+        size += 1 + literal;
+        i += literal;
+      }
+      return size;
+    }
+    static void _decode(const uint8_t* in, uint8_t* row)
+    {
+      const uint16_t wb = GxEPD2_Type::WIDTH / 8;
+      for (uint16_t i = 0; i < wb;)
+      {
+        uint8_t n = *in++;
+        if (n & 0x80)
+        {
+          memset(row + i, *in++, n - 0x7F);
+          i += n - 0x7F;
+        }
+        else
+        {
+          memcpy(row + i, in, n + 1);
+          in += n + 1;
+          i += n + 1;
+        }
+      }
+    }
+  private:
+    uint8_t* _arena;
+    uint16_t _size;
+    uint16_t* _offset; // row index, at the start of the arena
+    uint16_t _gap_row, _gap_start, _gap_end;
+    uint8_t _cache[cache_rows][GxEPD2_Type::WIDTH / 8];
+    int16_t _cache_y[cache_rows];
+    bool _cache_dirty[cache_rows];
+    uint8_t _slot, _cache_next;
+    bool _mirror, _ready, _overflow;
+};
+
+#endif
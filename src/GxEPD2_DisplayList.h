@@ -0,0 +1,305 @@
+// Display Library for SPI e-paper panels from Dalian Good Display and boards from Waveshare.
+// Requires HW SPI and Adafruit_GFX. Caution: these e-papers require 3.3V supply AND data lines!
+//
+// based on Demo Example from Good Display: http://www.good-display.com/download_list/downloadcategoryid=34&isMode=false.html
+//
+// Author: Jean-Marc Zingg
+//
+// Version: see library.properties
+//
+// Library: https://github.com/ZinggJM/GxEPD2
+
+#ifndef _GxEPD2_DisplayList_H_
+#define _GxEPD2_DisplayList_H_
+
+#include <Arduino.h>
+#include <Adafruit_GFX.h>
+
+// records Adafruit_GFX drawing once per frame, as compact commands with bounding boxes, in an arena provided by the application
+// replay() draws only the commands that intersect the current page of the display (GxEPD2_BW, GxEPD2_3C, GxEPD2_4G or GxEPD2_GFX)
+// the application draws to the display list instead of the display, then calls drawPaged(), or replay() inside its own picture loop
+// bitmaps and fonts are referenced, not copied; they need to stay valid until the frame is drawn
+template<typename GxEPD2_Display>
+class GxEPD2_DisplayList : public Adafruit_GFX
+{
+  public:
+    GxEPD2_DisplayList(GxEPD2_Display& display, uint8_t* arena, uint16_t arena_size) :
+      Adafruit_GFX(display.epd2.WIDTH, display.epd2.HEIGHT), _display(display), _arena(arena), _size(arena_size)
+    {
+      _text.font = 0;
+      _text.color = 0xFFFF;
+      _text.bg = 0xFFFF;
+      _text.size = 1;
+      _text.wrap = true;
+      clear();
+    }
+    // start recording a new frame, with the current rotation of the display; text settings are kept
+    void clear()
+    {
+      _used = 0;
+      _overflow = false;
+      setRotation(_display.getRotation());
+      _record(TextState, 0, 0, 0, 0, &_text, sizeof(_text));
+    }
+    // true if commands were dropped, arena too small; the frame is incomplete
+    bool overflow()
+    {
+      return _overflow;
+    }
+    // arena bytes used
+    uint16_t used()
+    {
+      return _used;
+    }
+    // draw the recorded commands that intersect the current page, inside the picture loop or drawCallback
+    void replay()
+    {
+      int16_t px, py, pw, ph;
+      _display.getPageBounds(px, py, pw, ph);
+      for (uint16_t i = 0; i < _used;)
+      {
+        Command c;
+        memcpy(&c, _arena + i, sizeof(c));
+        const uint8_t* payload = _arena + i + sizeof(c);
+        i += c.len;
+        if ((c.op != TextState) && !((c.x < px + pw) && (px < c.x + c.w) && (c.y < py + ph) && (py < c.y + c.h))) continue;
+        _replay(c, payload);
+      }
+    }
+    // paged full refresh of the recorded frame
+    void drawPaged()
+    {
+      _display.drawPaged(_replayCallback, this);
+    }
+    // Adafruit_GFX drawing, recorded
+    void drawPixel(int16_t x, int16_t y, uint16_t color)
+    {
+      _record(Pixel, x, y, 1, 1, &color, sizeof(color));
+    }
+    void drawFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color)
+    {
+      fillRect(x, y, w, 1, color);
+    }
+    void drawFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color)
+    {
+      fillRect(x, y, 1, h, color);
+    }
+    void fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color)
+    {
+      if (w < 0)
+      {
+        x += w + 1;
+        w = -w;
+      }
+      if (h < 0)
+      {
+        y += h + 1;
+        h = -h;
+      }
+      _record(FillRect, x, y, w, h, &color, sizeof(color));
+    }
+    void fillScreen(uint16_t color)
+    {
+      _record(FillScreen, 0, 0, width(), height(), &color, sizeof(color));
+    }
+    void drawLine(int16_t x0, int16_t y0, int16_t x1, int16_t y1, uint16_t color)
+    {
+      if ((x0 == x1) || (y0 == y1))
+      {
+        fillRect(x0 < x1 ? x0 : x1, y0 < y1 ? y0 : y1, abs(x1 - x0) + 1, abs(y1 - y0) + 1, color);
+        return;
+      }
+      if (x0 > x1)
+      {
+        int16_t t = x0;
+        x0 = x1;
+        x1 = t;
+        t = y0;
+        y0 = y1;
+        y1 = t;
+      }
+      if (y0 < y1) _record(Line, x0, y0, x1 - x0 + 1, y1 - y0 + 1, &color, sizeof(color));
+      else _record(LineUp, x0, y1, x1 - x0 + 1, y0 - y1 + 1, &color, sizeof(color));
+    }
+    void drawCircle(int16_t x0, int16_t y0, int16_t r, uint16_t color)
+    {
+      _record(Circle, x0 - r, y0 - r, 2 * r + 1, 2 * r + 1, &color, sizeof(color));
+    }
+    void fillCircle(int16_t x0, int16_t y0, int16_t r, uint16_t color)
+    {
+      _record(FillCircle, x0 - r, y0 - r, 2 * r + 1, 2 * r + 1, &color, sizeof(color));
+    }
+    void drawInvertedBitmap(int16_t x, int16_t y, const uint8_t bitmap[], int16_t w, int16_t h, uint16_t color)
+    {
+      _recordBitmap(InvertedBitmap, x, y, bitmap, w, h, color, color);
+    }
+    void drawBitmap(int16_t x, int16_t y, const uint8_t bitmap[], int16_t w, int16_t h, uint16_t color)
+    {
+      _recordBitmap(Bitmap, x, y, bitmap, w, h, color, color);
+    }
+    void drawBitmap(int16_t x, int16_t y, const uint8_t bitmap[], int16_t w, int16_t h, uint16_t color, uint16_t bg)
+    {
+      _recordBitmap(BitmapBg, x, y, bitmap, w, h, color, bg);
+    }
+    void drawBitmap(int16_t x, int16_t y, uint8_t* bitmap, int16_t w, int16_t h, uint16_t color)
+    {
+      _recordBitmap(BitmapRAM, x, y, bitmap, w, h, color, color);
+    }
+    void drawBitmap(int16_t x, int16_t y, uint8_t* bitmap, int16_t w, int16_t h, uint16_t color, uint16_t bg)
+    {
+      _recordBitmap(BitmapRAMBg, x, y, bitmap, w, h, color, bg);
+    }
+    // text settings, recorded
+    void setFont(const GFXfont* f = NULL)
+    {
+      Adafruit_GFX::setFont(f);
+      _text.font = f;
+      _record(TextState, 0, 0, 0, 0, &_text, sizeof(_text));
+    }
+    void setTextColor(uint16_t c)
+    {
+      setTextColor(c, c); // same as Adafruit_GFX: transparent background
+    }
+    void setTextColor(uint16_t c, uint16_t bg)
+    {
+      Adafruit_GFX::setTextColor(c, bg);
+      _text.color = c;
+      _text.bg = bg;
+      _record(TextState, 0, 0, 0, 0, &_text, sizeof(_text));
+    }
+    void setTextSize(uint8_t s)
+    {
+      Adafruit_GFX::setTextSize(s);
+      _text.size = s > 0 ? s : 1;
+      _record(TextState, 0, 0, 0, 0, &_text, sizeof(_text));
+    }
+    void setTextWrap(bool w)
+    {
+      Adafruit_GFX::setTextWrap(w);
+      _text.wrap = w;
+      _record(TextState, 0, 0, 0, 0, &_text, sizeof(_text));
+    }
+    // one command per glyph, at the cursor before wrap
+    size_t write(uint8_t c)
+    {
+      int16_t x = cursor_x, y = cursor_y;
+      int16_t minx = 0x7FFF, miny = 0x7FFF, maxx = -0x7FFF, maxy = -0x7FFF;
+      charBounds(c, &x, &y, &minx, &miny, &maxx, &maxy);
+      if (maxx >= minx)
+      {
+        Glyph g = {cursor_x, cursor_y, c};
+        _record(GlyphChar, minx, miny, maxx - minx + 1, maxy - miny + 1, &g, sizeof(g));
+      }
+      cursor_x = x;
+      cursor_y = y;
+      return 1;
+    }
+  private:
+    enum Op {FillScreen, Pixel, FillRect, Line, LineUp, Circle, FillCircle,
+             Bitmap, BitmapBg, BitmapRAM, BitmapRAMBg, InvertedBitmap, TextState, GlyphChar
+            };
+    struct Command
+    {
+      uint8_t op, len; // len : bytes, including payload
+      int16_t x, y, w, h; // bounding box, display coordinates
+    };
+    struct Image
+    {
+      const uint8_t* bitmap;
+      uint16_t color, bg;
+    };
+    struct Text
+    {
+      const GFXfont* font;
+      uint16_t color, bg;
+      uint8_t size;
+      bool wrap;
+    };
+    struct Glyph
+    {
+      int16_t x, y;
+      uint8_t c;
+    };
+    static void _replayCallback(const void* pv)
+    {
+      ((GxEPD2_DisplayList*)pv)->replay();
+    }
+    void _record(uint8_t op, int16_t x, int16_t y, int16_t w, int16_t h, const void* payload, uint8_t size)
+    {
+      if (_overflow) return; // keep the recorded part consistent
+      if ((op != TextState) && ((w <= 0) || (h <= 0) || (x >= width()) || (y >= height()) || (x + w <= 0) || (y + h <= 0))) return;
+      Command c = {op, uint8_t(sizeof(Command) + size), x, y, w, h};
+      if (uint32_t(_used) + c.len > _size)
+      {
+        _overflow = true;
+        return;
+      }
+      memcpy(_arena + _used, &c, sizeof(c));
+      memcpy(_arena + _used + sizeof(c), payload, size);
+      _used += c.len;
+    }
+    void _recordBitmap(uint8_t op, int16_t x, int16_t y, const uint8_t* bitmap, int16_t w, int16_t h, uint16_t color, uint16_t bg)
+    {
+      Image image = {bitmap, color, bg};
+      _record(op, x, y, w, h, &image, sizeof(image));
+    }
+    void _replay(const Command& c, const uint8_t* payload)
+    {
+      uint16_t color;
+      Image image;
+      Text text;
+      Glyph g;
+      memcpy(&color, payload, sizeof(color));
+      switch (c.op)
+      {
+        case FillScreen:
+          _display.fillScreen(color);
+          break;
+        case Pixel:
+          _display.drawPixel(c.x, c.y, color);
+          break;
+        case FillRect:
+          _display.fillRect(c.x, c.y, c.w, c.h, color);
+          break;
+        case Line:
+          _display.drawLine(c.x, c.y, c.x + c.w - 1, c.y + c.h - 1, color);
+          break;
+        case LineUp:
+          _display.drawLine(c.x, c.y + c.h - 1, c.x + c.w - 1, c.y, color);
+          break;
+        case Circle:
+          _display.drawCircle(c.x + c.w / 2, c.y + c.h / 2, c.w / 2, color);
+          break;
+        case FillCircle:
+          _display.fillCircle(c.x + c.w / 2, c.y + c.h / 2, c.w / 2, color);
+          break;
+        case TextState:
+          memcpy(&text, payload, sizeof(text));
+          _display.setFont(text.font);
+          _display.setTextColor(text.color, text.bg);
+          _display.setTextSize(text.size);
+          _display.setTextWrap(text.wrap);
+          break;
+        case GlyphChar:
+          memcpy(&g, payload, sizeof(g));
+          _display.setCursor(g.x, g.y);
+          _display.write(g.c);
+          break;
+        default:
+          memcpy(&image, payload, sizeof(image));
+          if (c.op == Bitmap) _display.drawBitmap(c.x, c.y, image.bitmap, c.w, c.h, image.color);
+          else if (c.op == BitmapBg) _display.drawBitmap(c.x, c.y, image.bitmap, c.w, c.h, image.color, image.bg);
+          else if (c.op == BitmapRAM) _display.drawBitmap(c.x, c.y, (uint8_t*)image.bitmap, c.w, c.h, image.color);
+          else if (c.op == BitmapRAMBg) _display.drawBitmap(c.x, c.y, (uint8_t*)image.bitmap, c.w, c.h, image.color, image.bg);
+          else if (c.op == InvertedBitmap) _display.drawInvertedBitmap(c.x, c.y, image.bitmap, c.w, c.h, image.color);
+      }
+    }
+  private:
+    GxEPD2_Display& _display;
+    uint8_t* _arena;
+    uint16_t _size, _used;
+    bool _overflow;
+    Text _text;
+};
+
+#endif
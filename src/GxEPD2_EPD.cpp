@@ -21,8 +21,15 @@ GxEPD2_EPD::GxEPD2_EPD(int8_t cs, int8_t dc, int8_t rst, int8_t busy, int8_t bus
                        uint16_t w, uint16_t h, GxEPD2::Panel p, bool c, bool pu, bool fpu) :
   WIDTH(w), HEIGHT(h), panel(p), hasColor(c), hasPartialUpdate(pu), hasFastPartialUpdate(fpu),
   _cs(cs), _dc(dc), _rst(rst), _busy(busy), _busy_level(busy_level), _busy_timeout(busy_timeout), _diag_enabled(false),
-  _spi_settings(4000000, MSBFIRST, SPI_MODE0)
+  _spi_settings(4000000, MSBFIRST, SPI_MODE0), _lut_registers(0), _lut_register_count(0),
+  _full_lut(GxEPD2::LutNormal), _partial_lut(GxEPD2::LutFast), _resident_lut(0), _bands(0), _band(-1)
 {
+  for (uint8_t i = 0; i < GxEPD2::LutSlots; i++)
+  {
+    _lut[i] = 0;
+    _lut_size[i] = 0;
+    _lut_pgm[i] = false;
+  }
 }
 
 void GxEPD2_EPD::init(uint32_t serial_diag_bitrate)
@@ -42,6 +49,7 @@ void GxEPD2_EPD::init(uint32_t serial_diag_bitrate)
     digitalWrite(_dc, HIGH);
     pinMode(_dc, OUTPUT);
   }
+  _resident_lut = 0;
   if (_rst >= 0)
   {
     digitalWrite(_rst, HIGH);
@@ -70,6 +78,107 @@ void GxEPD2_EPD::init(uint32_t serial_diag_bitrate)
   //#endif
 }
 
+bool GxEPD2_EPD::setLut(GxEPD2::LutSlot slot, const uint8_t* lut, uint16_t size, bool pgm)
+{
+  if ((slot >= GxEPD2::LutSlots) || (_lut_register_count == 0) || !lut) return false;
+  uint16_t found = 0; // bit per LUT register, max 16
+  uint16_t i = 0;
+  while (i + 2 <= size)
+  {
+    uint8_t command = pgm ? pgm_read_byte(lut + i) : lut[i];
+    uint8_t length = pgm ? pgm_read_byte(lut + i + 1) : lut[i + 1];
+    uint8_t r = 0;
+    while ((r < _lut_register_count) && (_lut_registers[r].command != command)) r++;
+    if ((r == _lut_register_count) || (_lut_registers[r].length != length) || (found & (1 << r))) return false;
+    found |= 1 << r;
+    i += 2 + length;
+  }
+  if ((i != size) || (found != (1 << _lut_register_count) - 1)) return false;
+  _lut[slot] = lut;
+  _lut_size[slot] = size;
+  _lut_pgm[slot] = pgm;
+  if (_resident_lut == slot + 1) _resident_lut = 0;
+  return true;
+}
+
+void GxEPD2_EPD::clearLut(GxEPD2::LutSlot slot)
+{
+  if (slot >= GxEPD2::LutSlots) return;
+  _lut[slot] = 0;
+  if (_resident_lut == slot + 1) _resident_lut = 0;
+}
+
+void GxEPD2_EPD::selectLut(GxEPD2::LutSlot full_refresh, GxEPD2::LutSlot partial_refresh)
+{
+  if ((full_refresh >= GxEPD2::LutSlots) || (partial_refresh >= GxEPD2::LutSlots)) return;
+  _full_lut = full_refresh;
+  _partial_lut = partial_refresh;
+}
+
+bool GxEPD2_EPD::setLutBand(uint8_t band, int8_t min_celsius, GxEPD2::LutSlot full_refresh, GxEPD2::LutSlot partial_refresh)
+{
+  if ((band >= LutBands) || (full_refresh >= GxEPD2::LutSlots) || (partial_refresh >= GxEPD2::LutSlots)) return false;
+  _band_min_celsius[band] = min_celsius;
+  _band_full_lut[band] = full_refresh;
+  _band_partial_lut[band] = partial_refresh;
+  _bands |= 1 << band;
+  if (_band == band) selectLut(full_refresh, partial_refresh);
+  return true;
+}
+void GxEPD2_EPD::clearLutBands()
+{
+  _bands = 0;
+  _band = -1;
+  selectLut(GxEPD2::LutNormal, GxEPD2::LutFast); // default selection
+}
+void GxEPD2_EPD::setTemperature(int8_t celsius)
+{
+  int8_t band = -1, lowest = -1;
+  for (uint8_t i = 0; i < LutBands; i++)
+  {
+    if (!(_bands & (1 << i))) continue;
+    if ((lowest < 0) || (_band_min_celsius[i] < _band_min_celsius[lowest])) lowest = i;
+    if ((_band_min_celsius[i] <= celsius) && ((band < 0) || (_band_min_celsius[i] > _band_min_celsius[band]))) band = i;
+  }
+  if (band < 0) band = lowest; // colder than all bands
+  if ((band < 0) || (band == _band)) return;
+  _band = band;
+  // resident LUT is kept if both bands use the same slots
+  selectLut(GxEPD2::LutSlot(_band_full_lut[band]), GxEPD2::LutSlot(_band_partial_lut[band]));
+}
+void GxEPD2_EPD::_setLutRegisters(const LutRegister* registers, uint8_t count)
+{
+  _lut_registers = registers;
+  _lut_register_count = count;
+}
+
+bool GxEPD2_EPD::_updateLut(bool partial_refresh)
+{
+  uint8_t slot = partial_refresh ? _partial_lut : _full_lut;
+  // resident id: custom slot + 1, or 0x80 default full, 0x81 default partial
+  uint8_t id = _lut[slot] ? slot + 1 : partial_refresh ? 0x81 : 0x80;
+  if (id == _resident_lut) return false;
+  _resident_lut = id;
+  if (!_lut[slot]) return true;
+  const uint8_t* lut = _lut[slot];
+  bool pgm = _lut_pgm[slot];
+  uint16_t i = 0;
+  while (i + 2 <= _lut_size[slot])
+  {
+    uint8_t length = pgm ? pgm_read_byte(lut + i + 1) : lut[i + 1];
+    _writeCommand(pgm ? pgm_read_byte(lut + i) : lut[i]);
+    _writeLutData(lut + i + 2, length, pgm);
+    i += 2 + length;
+  }
+  return false;
+}
+
+void GxEPD2_EPD::_writeLutData(const uint8_t* data, uint16_t n, bool pgm)
+{
+  if (pgm) _writeDataPGM(data, n);
+  else _writeData(data, n);
+}
+
 void GxEPD2_EPD::_waitWhileBusy(const char* comment, uint16_t busy_time)
 {
   if (_busy >= 0)
@@ -45,6 +45,14 @@ class GxEPD2
       GDEW0583Z21, Waveshare_5_83_bwr = GDEW0583Z21,
       GDEW075Z09,  Waveshare_7_5_bwr = GDEW075Z09
     };
+    enum LutSlot
+    {
+      LutFast, LutNormal, LutQuality, LutSlots
+    };
+    enum RasterOp // bitwise on pixel values of the buffer, white is 1
+    {
+      RopCopy, RopOr, RopAnd, RopXor
+    };
 };
 
 class GxEPD2_EPD
@@ -73,6 +81,23 @@ class GxEPD2_EPD
     virtual void refresh(bool partial_update_mode = false) = 0; // screen refresh from controller memory to full screen
     virtual void refresh(int16_t x, int16_t y, int16_t w, int16_t h) = 0; // screen refresh from controller memory, partial screen
     virtual void setPaged() {}; // for GxEPD2_154c paged workaround
+    // runtime waveform (LUT) sets, for panels with LUT registers; layout: [command][length][data]... for each LUT register
+    // returns false if the panel uses OTP LUT only or the layout doesn't match the LUT registers of the controller
+    bool setLut(GxEPD2::LutSlot slot, const uint8_t* lut, uint16_t size, bool pgm = false);
+    void clearLut(GxEPD2::LutSlot slot); // use the built-in waveform for this slot
+    // slots used for full and partial refresh, default LutNormal, LutFast; takes effect with the next refresh
+    void selectLut(GxEPD2::LutSlot full_refresh, GxEPD2::LutSlot partial_refresh);
+    // temperature compensation with LUT slots per temperature band, e.g. LutQuality cold, LutFast warm
+    // band applies from min_celsius up to the min_celsius of the next band; the lowest band also applies below
+    static const uint8_t LutBands = 4;
+    bool setLutBand(uint8_t band, int8_t min_celsius, GxEPD2::LutSlot full_refresh, GxEPD2::LutSlot partial_refresh);
+    void clearLutBands(); // back to the default selection, LutNormal, LutFast
+    // panel temperature, supplied by the application; selects the band, the LUT is rewritten only if the band changes
+    void setTemperature(int8_t celsius);
+    int8_t lutBand() // selected band, -1 : none
+    {
+      return _band;
+    };
     static inline uint16_t gx_uint16_min(uint16_t a, uint16_t b)
     {
       return (a < b ? a : b);
@@ -81,7 +106,15 @@ class GxEPD2_EPD
     {
       return (a > b ? a : b);
     };
+    struct LutRegister
+    {
+      uint8_t command, length;
+    };
   protected:
+    void _setLutRegisters(const LutRegister* registers, uint8_t count); // for drivers with LUT registers
+    // uploads the custom LUT set of the selected slot, if not resident; returns true if the driver needs to upload its default LUT
+    bool _updateLut(bool partial_refresh);
+    virtual void _writeLutData(const uint8_t* data, uint16_t n, bool pgm);
     void _waitWhileBusy(const char* comment = 0, uint16_t busy_time = 5000);
     void _writeCommand(uint8_t c);
     void _writeData(uint8_t d);
@@ -94,6 +127,16 @@ class GxEPD2_EPD
     uint32_t _busy_timeout;
     bool _diag_enabled;
     SPISettings _spi_settings;
+    const LutRegister* _lut_registers;
+    uint8_t _lut_register_count;
+    const uint8_t* _lut[GxEPD2::LutSlots];
+    uint16_t _lut_size[GxEPD2::LutSlots];
+    bool _lut_pgm[GxEPD2::LutSlots];
+    uint8_t _full_lut, _partial_lut, _resident_lut; // _resident_lut 0 : unknown, e.g. after reset
+    int8_t _band_min_celsius[LutBands];
+    uint8_t _band_full_lut[LutBands], _band_partial_lut[LutBands];
+    uint8_t _bands; // bit per band set
+    int8_t _band;
 };
 
 #endif
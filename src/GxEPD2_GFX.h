@@ -13,6 +13,9 @@
 #define _GxEPD2_GFX_H_
 
 #include <Adafruit_GFX.h>
+#include "GxEPD2_RefreshPlanner.h"
+#include "GxEPD2_RefreshPolicy.h"
+#include "GxEPD2_GlyphCache.h"
 
 class GxEPD2_GFX : public Adafruit_GFX
 {
@@ -22,12 +25,21 @@ class GxEPD2_GFX : public Adafruit_GFX
     virtual void init(uint32_t serial_diag_bitrate = 0) = 0; // serial_diag_bitrate = 0 : disabled
     virtual void fillScreen(uint16_t color) = 0; // 0x0 black, >0x0 white, to buffer
     virtual void display(bool partial_update_mode = false) = 0;
+    virtual void displayChanged() = 0; // write and refresh changed region only, for full screen buffer
+    virtual void displayRegions(const GxEPD2_Region regions[], uint8_t count) = 0; // for full screen buffer
+    // optional, the defaults ignore refresh policy and glyph cache, and have no ping-pong buffers (e.g. GxEPD2_4G)
+    virtual void setRefreshPolicy(GxEPD2_RefreshPolicy* policy) {}; // NULL detaches
+    virtual bool idleRefresh() {return false;}; // full refresh if pending by refresh policy
+    virtual void setGlyphCache(GxEPD2_GlyphCache* cache) {}; // NULL detaches
+    virtual bool setPingPong(bool enable) {return !enable;}; // false if not supported
     virtual void setFullWindow() = 0;
     virtual void setPartialWindow(uint16_t x, uint16_t y, uint16_t w, uint16_t h) = 0;
     virtual void firstPage() = 0;
     virtual bool nextPage() = 0;
     virtual void drawPaged(void (*drawCallback)(const void*), const void* pv) = 0;
     virtual void drawInvertedBitmap(int16_t x, int16_t y, const uint8_t bitmap[], int16_t w, int16_t h, uint16_t color) = 0;
+    virtual void getPageBounds(int16_t& x, int16_t& y, int16_t& w, int16_t& h) = 0; // current page, display coordinates
+    virtual bool intersectsPage(int16_t x, int16_t y, int16_t w, int16_t h) = 0;
     //  Support for Bitmaps (Sprites) to Controller Buffer and to Screen
     virtual void clearScreen(uint8_t value = 0xFF) = 0; // init controller memory and screen (default white)
     virtual void writeScreenBuffer(uint8_t value = 0xFF) = 0; // init controller memory (default white)
@@ -0,0 +1,199 @@
+// Display Library for SPI e-paper panels from Dalian Good Display and boards from Waveshare.
+// Requires HW SPI and Adafruit_GFX. Caution: these e-papers require 3.3V supply AND data lines!
+//
+// based on Demo Example from Good Display: http://www.good-display.com/download_list/downloadcategoryid=34&isMode=false.html
+//
+// Author: Jean-Marc Zingg
+//
+// Version: see library.properties
+//
+// Library: https://github.com/ZinggJM/GxEPD2
+
+#ifndef _GxEPD2_GlyphCache_H_
+#define _GxEPD2_GlyphCache_H_
+
+#include <Arduino.h>
+#include <Adafruit_GFX.h>
+
+// keeps GFXfont glyphs rasterised as byte aligned 1bpp bitmaps (rows padded to bytes), in an arena provided by the application
+// the arena is divided in slots of slot_size bytes; the least recently used glyph is replaced when all slots are used
+// attach to GxEPD2_BW or GxEPD2_3C with setGlyphCache(); used for text size 1, glyphs bigger than a slot are drawn by Adafruit_GFX
+class GxEPD2_GlyphCache
+{
+  public:
+    GxEPD2_GlyphCache(uint8_t* arena, uint16_t arena_size, uint16_t slot_size = 64) : _slot_size(slot_size), _buckets(1)
+    {
+      // arena : slot headers, hash buckets, glyph data
+      uint16_t pad = (alignof(Slot) - uintptr_t(arena) % alignof(Slot)) % alignof(Slot);
+      uint16_t size = arena_size > pad ? arena_size - pad : 0;
+      _slots = size / (sizeof(Slot) + sizeof(uint16_t) + slot_size);
+      while (_buckets * 2 <= _slots) _buckets *= 2;
+      _slot = (Slot*)(arena + pad);
+      _bucket = (uint16_t*)(_slot + _slots);
+      _data = (uint8_t*)(_bucket + _buckets);
+      clear();
+    }
+    // forget all glyphs, e.g. if a font in RAM was changed
+    void clear()
+    {
+      _stamp = 0;
+      _hits = 0;
+      _misses = 0;
+      for (uint16_t i = 0; i < _slots; i++)
+      {
+        Slot s = {0, 0, _none, 0, false};
+        _slot[i] = s;
+      }
+      for (uint16_t i = 0; (i < _buckets) && (_slots > 0); i++) _bucket[i] = _none;
+    }
+    // bitmap of glyph c of font, rasterised on first use; NULL if c is not in font or too big for a slot
+    // glyphs too big for a slot are remembered without bitmap, not read from font again; valid until the next call
+    const uint8_t* get(const GFXfont* font, uint8_t c)
+    {
+      if (!font || (_slots == 0)) return 0;
+      if (++_stamp == 0) _restamp();
+      uint16_t& bucket = _bucket[_hash(font, c)];
+      for (uint16_t i = bucket; i != _none; i = _slot[i].next)
+      {
+        if ((_slot[i].font == font) && (_slot[i].c == c))
+        {
+          _slot[i].stamp = _stamp;
+          _hits++;
+          return _slot[i].fits ? _glyph(i) : 0;
+        }
+      }
+      _misses++;
+      GFXfont f;
+      GFXglyph g;
+      _readFlash(&f, font, sizeof(f));
+      if ((c < f.first) || (c > f.last)) return 0;
+      _readFlash(&g, &f.glyph[c - f.first], sizeof(g));
+      uint16_t wb = (g.width + 7) / 8;
+      bool fits = (g.width > 0) && (g.height > 0) && (uint32_t(wb) * g.height <= _slot_size);
+      uint16_t lru = _evict();
+      if (fits) _rasterise(f.bitmap + g.bitmapOffset, g.width, g.height, _glyph(lru));
+      Slot s = {font, _stamp, bucket, c, fits};
+      _slot[lru] = s;
+      bucket = lru;
+      return fits ? _glyph(lru) : 0;
+    }
+    // where Adafruit_GFX::write(c) draws glyph c, and the cursor after it; font NULL : classic 6x8 font
+    // only public Adafruit_GFX methods, its versions keep text size and cursor in different members
+    struct Placement
+    {
+      int16_t x, y; // glyph bounds, after wrap
+      uint16_t w, h;
+      int16_t cursor_x, cursor_y; // after the glyph
+      bool size1; // text size 1, the bounds are the glyph bitmap
+    };
+    // false for line feeds, empty glyphs and glyphs off screen (getTextBounds() clamps these), leave them to Adafruit_GFX
+    static bool place(Adafruit_GFX& gfx, const GFXfont* font, uint8_t c, Placement& p)
+    {
+      char s[2] = {char(c), 0};
+      gfx.getTextBounds(s, gfx.getCursorX(), gfx.getCursorY(), &p.x, &p.y, &p.w, &p.h);
+      if (!p.w || !p.h || (p.x >= gfx.width()) || (p.x + int16_t(p.w) <= 0) || (p.y >= gfx.height()) || (p.y + int16_t(p.h) <= 0)) return false;
+      GFXglyph g = {0, 6, 8, 6, 0, 0}; // classic font cell
+      if (font)
+      {
+        GFXfont f;
+        _readFlash(&f, font, sizeof(f));
+        if ((c < f.first) || (c > f.last)) return false;
+        _readFlash(&g, &f.glyph[c - f.first], sizeof(g));
+      }
+      int16_t sx = p.w / g.width, sy = p.h / g.height; // text size
+      p.cursor_x = p.x - g.xOffset * sx + g.xAdvance * sx;
+      p.cursor_y = p.y - g.yOffset * sy;
+      p.size1 = (sx == 1) && (sy == 1);
+      return true;
+    }
+    // number of glyphs that can be kept
+    uint16_t slots()
+    {
+      return _slots;
+    }
+    // statistics, e.g. to choose arena and slot size
+    uint32_t hits()
+    {
+      return _hits;
+    }
+    uint32_t misses()
+    {
+      return _misses;
+    }
+  private:
+    struct Slot
+    {
+      const GFXfont* font; // NULL : unused
+      uint16_t stamp; // last use
+      uint16_t next; // next slot of the same hash bucket
+      uint8_t c;
+      bool fits; // false : too big for a slot, drawn by Adafruit_GFX
+    };
+    static const uint16_t _none = 0xFFFF;
+    uint16_t _hash(const GFXfont* font, uint8_t c)
+    {
+      return (c ^ uint16_t(uintptr_t(font) >> 3)) & (_buckets - 1);
+    }
+    uint8_t* _glyph(uint16_t i)
+    {
+      return _data + uint32_t(i) * _slot_size;
+    }
+    // least recently used slot, unlinked from its hash bucket
+    uint16_t _evict()
+    {
+      uint16_t lru = 0;
+      for (uint16_t i = 1; i < _slots; i++)
+      {
+        if (_slot[i].stamp < _slot[lru].stamp) lru = i;
+      }
+      if (_slot[lru].font)
+      {
+        uint16_t* link = &_bucket[_hash(_slot[lru].font, _slot[lru].c)];
+        while (*link != lru) link = &_slot[*link].next;
+        *link = _slot[lru].next;
+      }
+      return lru;
+    }
+    // stamp overflow: restart, the cached glyphs become equally old
+    void _restamp()
+    {
+      for (uint16_t i = 0; i < _slots; i++)
+      {
+        if (_slot[i].font) _slot[i].stamp = 1;
+      }
+      _stamp = 2;
+    }
+    // GFXfont glyph bits are packed continuously, rows are padded to bytes here
+    static void _rasterise(const uint8_t* bits, uint8_t w, uint8_t h, uint8_t* dst)
+    {
+      uint16_t wb = (w + 7) / 8;
+      uint32_t bit = 0;
+      uint8_t byte = 0;
+      for (uint8_t y = 0; y < h; y++)
+      {
+        uint8_t* row = dst + uint16_t(y) * wb;
+        memset(row, 0, wb);
+        for (uint8_t x = 0; x < w; x++, bit++)
+        {
+          if ((bit & 7) == 0) _readFlash(&byte, bits + bit / 8, 1);
+          if (byte & (0x80 >> (bit & 7))) row[x / 8] |= 0x80 >> (x & 7);
+        }
+      }
+    }
+    static void _readFlash(void* dst, const void* src, uint16_t size)
+    {
+#if defined(__AVR) || defined(ESP8266) || defined(ESP32)
+      for (uint16_t i = 0; i < size; i++) ((uint8_t*)dst)[i] = pgm_read_byte((const uint8_t*)src + i);
+#else
+      memcpy(dst, src, size);
+#endif
+    }
+  private:
+    Slot* _slot;
+    uint16_t* _bucket;
+    uint8_t* _data;
+    uint16_t _slot_size, _slots, _buckets, _stamp;
+    uint32_t _hits, _misses;
+};
+
+#endif
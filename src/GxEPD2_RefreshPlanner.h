@@ -0,0 +1,181 @@
+// Display Library for SPI e-paper panels from Dalian Good Display and boards from Waveshare.
+// Requires HW SPI and Adafruit_GFX. Caution: these e-papers require 3.3V supply AND data lines!
+//
+// based on Demo Example from Good Display: http://www.good-display.com/download_list/downloadcategoryid=34&isMode=false.html
+//
+// Author: Jean-Marc Zingg
+//
+// Version: see library.properties
+//
+// Library: https://github.com/ZinggJM/GxEPD2
+
+#ifndef _GxEPD2_RefreshPlanner_H_
+#define _GxEPD2_RefreshPlanner_H_
+
+#include "GxEPD2_EPD.h"
+
+struct GxEPD2_Region
+{
+  uint16_t x, y, w, h;
+};
+
+// decides between separate partial refreshes, merged partial refreshes or one full refresh of changed regions
+// regions are in controller coordinates; cost model uses the refresh times of the driver class:
+// partial refresh time = fixed part + area part * region area / screen area
+template<typename GxEPD2_Type, const uint8_t max_regions = 8>
+class GxEPD2_RefreshPlanner
+{
+  public:
+    GxEPD2_RefreshPlanner()
+    {
+      if (GxEPD2_Type::hasFastPartialUpdate)
+      {
+        setCost(GxEPD2_Type::partial_refresh_time / 2, GxEPD2_Type::partial_refresh_time / 2, GxEPD2_Type::full_refresh_time);
+      }
+      else setCost(GxEPD2_Type::partial_refresh_time, 0, GxEPD2_Type::full_refresh_time);
+      clear();
+    }
+    // times in ms; area_ms is the additional time for a partial refresh of the full screen area
+    void setCost(uint16_t partial_fixed_ms, uint16_t partial_area_ms, uint16_t full_ms)
+    {
+      _fixed_ms = partial_fixed_ms;
+      _area_ms = partial_area_ms;
+      _full_ms = full_ms;
+    }
+    void clear()
+    {
+      _count = 0;
+      _full = false;
+    }
+    // add region, x and w get byte aligned; if all slots are used the region is merged into the closest one
+    void add(int16_t x, int16_t y, int16_t w, int16_t h)
+    {
+      if (x < 0)
+      {
+        w += x;
+        x = 0;
+      }
+      if (y < 0)
+      {
+        h += y;
+        y = 0;
+      }
+      if (x + w > int16_t(GxEPD2_Type::WIDTH)) w = int16_t(GxEPD2_Type::WIDTH) - x;
+      if (y + h > int16_t(GxEPD2_Type::HEIGHT)) h = int16_t(GxEPD2_Type::HEIGHT) - y;
+      if ((w <= 0) || (h <= 0)) return;
+      GxEPD2_Region r;
+      r.x = x - x % 8;
+      r.w = ((x + w + 7) & 0xFFF8) - r.x;
+      r.y = y;
+      r.h = h;
+      if (_count < max_regions)
+      {
+        _regions[_count++] = r;
+        return;
+      }
+      uint8_t best = 0;
+      uint32_t best_growth = 0xFFFFFFFF;
+      for (uint8_t i = 0; i < _count; i++)
+      {
+        GxEPD2_Region m = _merged(_regions[i], r);
+        uint32_t growth = _area(m) - _area(_regions[i]);
+        if (growth < best_growth)
+        {
+          best = i;
+          best_growth = growth;
+        }
+      }
+      _regions[best] = _merged(_regions[best], r);
+    }
+    // merge regions while this reduces the estimated time, then compare with a full refresh
+    // returns the number of refresh operations planned
+    uint8_t plan(bool allow_full_refresh = true)
+    {
+      _full = false;
+      while (_count > 1)
+      {
+        uint8_t bi = 0, bj = 0;
+        int32_t best_saving = -1;
+        for (uint8_t i = 0; i < _count; i++)
+        {
+          for (uint8_t j = i + 1; j < _count; j++)
+          {
+            int32_t saving = int32_t(_cost(_regions[i]) + _cost(_regions[j])) - int32_t(_cost(_merged(_regions[i], _regions[j])));
+            if (saving > best_saving)
+            {
+              bi = i;
+              bj = j;
+              best_saving = saving;
+            }
+          }
+        }
+        if (best_saving < 0) break;
+        _regions[bi] = _merged(_regions[bi], _regions[bj]);
+        _regions[bj] = _regions[--_count];
+      }
+      if (allow_full_refresh && (_count > 0) && (_full_ms <= cost())) _full = true;
+      return _full ? 1 : _count;
+    }
+    // estimated time of the planned refresh sequence in ms
+    uint32_t cost()
+    {
+      if (_full) return _full_ms;
+      uint32_t sum = 0;
+      for (uint8_t i = 0; i < _count; i++)
+      {
+        sum += _cost(_regions[i]);
+      }
+      return sum;
+    }
+    bool isFullRefresh()
+    {
+      return _full;
+    }
+    uint8_t regions()
+    {
+      return _count;
+    }
+    const GxEPD2_Region& region(uint8_t i)
+    {
+      return _regions[i];
+    }
+    // issue the planned refresh sequence, controller memory must have been written before
+    void refresh(GxEPD2_Type& epd2)
+    {
+      if (_full) epd2.refresh(false);
+      else
+      {
+        for (uint8_t i = 0; i < _count; i++)
+        {
+          epd2.refresh(_regions[i].x, _regions[i].y, _regions[i].w, _regions[i].h);
+        }
+      }
+    }
+  private:
+    static uint32_t _area(const GxEPD2_Region& r)
+    {
+      return uint32_t(r.w) * uint32_t(r.h);
+    }
+    static GxEPD2_Region _merged(const GxEPD2_Region& a, const GxEPD2_Region& b)
+    {
+      GxEPD2_Region m;
+      m.x = a.x < b.x ? a.x : b.x;
+      m.y = a.y < b.y ? a.y : b.y;
+      m.w = (a.x + a.w > b.x + b.w ? a.x + a.w : b.x + b.w) - m.x;
+      m.h = (a.y + a.h > b.y + b.h ? a.y + a.h : b.y + b.h) - m.y;
+      return m;
+    }
+    uint32_t _cost(const GxEPD2_Region& r)
+    {
+      // area fraction in 1/256 to stay within 32 bits
+      uint32_t fraction = (_area(r) * 256) / (uint32_t(GxEPD2_Type::WIDTH) * uint32_t(GxEPD2_Type::HEIGHT));
+      return _fixed_ms + (uint32_t(_area_ms) * fraction) / 256;
+    }
+  private:
+    GxEPD2_Region _regions[max_regions];
+    uint8_t _count;
+    bool _full;
+    uint16_t _fixed_ms, _area_ms, _full_ms;
+};
+
+#endif
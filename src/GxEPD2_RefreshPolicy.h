@@ -0,0 +1,94 @@
+// Display Library for SPI e-paper panels from Dalian Good Display and boards from Waveshare.
+// Requires HW SPI and Adafruit_GFX. Caution: these e-papers require 3.3V supply AND data lines!
+//
+// based on Demo Example from Good Display: http://www.good-display.com/download_list/downloadcategoryid=34&isMode=false.html
+//
+// Author: Jean-Marc Zingg
+//
+// Version: see library.properties
+//
+// Library: https://github.com/ZinggJM/GxEPD2
+
+#ifndef _GxEPD2_RefreshPolicy_H_
+#define _GxEPD2_RefreshPolicy_H_
+
+#include <Arduino.h>
+
+// counts partial refreshes and refreshed area per grid cell since the last full refresh,
+// and asks for a full refresh (ghosting cleanup) when a cell reaches one of the limits
+// attach to GxEPD2_BW or GxEPD2_3C with setRefreshPolicy(); coordinates are controller coordinates
+class GxEPD2_RefreshPolicy
+{
+  public:
+    static const uint8_t grid = 4; // cells per direction
+    // max_changed_area_percent : sum of partially refreshed area in a cell, in percent of cell area
+    // defer_to_idle : don't replace the partial refresh, wait for idleRefresh() of the display class
+    GxEPD2_RefreshPolicy(uint8_t max_partial_refreshes = 10, uint16_t max_changed_area_percent = 500, bool defer_to_idle = false) :
+      _max_count(max_partial_refreshes), _max_area(max_changed_area_percent), _defer(defer_to_idle), _width(0), _height(0)
+    {
+      fullRefresh();
+    }
+    void begin(uint16_t width, uint16_t height)
+    {
+      _width = width;
+      _height = height;
+      fullRefresh();
+    }
+    // record a partial refresh; returns true if it should be replaced by a full refresh
+    bool partialRefresh(int16_t x, int16_t y, int16_t w, int16_t h)
+    {
+      if ((_width == 0) || (_height == 0)) return false;
+      uint16_t cw = (_width + grid - 1) / grid;
+      uint16_t ch = (_height + grid - 1) / grid;
+      for (uint8_t r = 0; r < grid; r++)
+      {
+        for (uint8_t c = 0; c < grid; c++)
+        {
+          int16_t cx1 = c * cw, cy1 = r * ch, cx2 = cx1 + cw, cy2 = cy1 + ch;
+          int16_t ix1 = x > cx1 ? x : cx1;
+          int16_t iy1 = y > cy1 ? y : cy1;
+          int16_t ix2 = x + w < cx2 ? x + w : cx2;
+          int16_t iy2 = y + h < cy2 ? y + h : cy2;
+          if ((ix2 <= ix1) || (iy2 <= iy1)) continue;
+          uint8_t i = r * grid + c;
+          if (_count[i] < 255) _count[i]++;
+          uint32_t area = _area[i] + (uint32_t(ix2 - ix1) * uint32_t(iy2 - iy1) * 100) / (uint32_t(cw) * uint32_t(ch));
+          _area[i] = area < 0xFFFF ? area : 0xFFFF;
+          if ((_count[i] >= _max_count) || (_area[i] >= _max_area)) _pending = true;
+        }
+      }
+      return _pending && !_defer;
+    }
+    // record a full refresh, resets all counters
+    void fullRefresh()
+    {
+      for (uint8_t i = 0; i < grid * grid; i++)
+      {
+        _count[i] = 0;
+        _area[i] = 0;
+      }
+      _pending = false;
+    }
+    // a limit has been reached, full refresh recommended
+    bool fullRefreshPending()
+    {
+      return _pending;
+    }
+    uint8_t partialRefreshes(uint8_t cell)
+    {
+      return _count[cell];
+    }
+    uint16_t changedAreaPercent(uint8_t cell)
+    {
+      return _area[cell];
+    }
+  private:
+    uint8_t _max_count;
+    uint16_t _max_area;
+    bool _defer, _pending;
+    uint16_t _width, _height;
+    uint8_t _count[grid * grid];
+    uint16_t _area[grid * grid];
+};
+
+#endif
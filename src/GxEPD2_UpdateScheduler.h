@@ -0,0 +1,218 @@
+// Display Library for SPI e-paper panels from Dalian Good Display and boards from Waveshare.
+// Requires HW SPI and Adafruit_GFX. Caution: these e-papers require 3.3V supply AND data lines!
+//
+// based on Demo Example from Good Display: http://www.good-display.com/download_list/downloadcategoryid=34&isMode=false.html
+//
+// Author: Jean-Marc Zingg
+//
+// Version: see library.properties
+//
+// Library: https://github.com/ZinggJM/GxEPD2
+
+#ifndef _GxEPD2_UpdateScheduler_H_
+#define _GxEPD2_UpdateScheduler_H_
+
+#include <Arduino.h>
+#include "GxEPD2_RefreshPlanner.h"
+
+struct GxEPD2_UpdateMetrics
+{
+  uint32_t submitted; // calls to update()
+  uint32_t superseded; // dropped, replaced by a newer update of the same id
+  uint32_t expired; // dropped, deadline passed before a refresh slot was available
+  uint32_t merged; // merged into another pending update, queue was full
+  uint32_t batched; // shown together with other updates in one refresh slot
+  uint32_t refreshes; // refresh slots used
+};
+
+// queues region updates of a full screen buffer display (GxEPD2_BW, GxEPD2_3C or GxEPD2_GFX)
+// and refreshes them in batches with displayRegions(), at most once per min_interval_ms
+// the application draws to the buffer and calls update() for the changed region, then calls loop() regularly
+template<typename GxEPD2_Display, const uint8_t max_updates = 8>
+class GxEPD2_UpdateScheduler
+{
+  public:
+    // min_interval_ms : refresh cadence, from start to start, e.g. GxEPD2_Type::partial_refresh_time or more
+    GxEPD2_UpdateScheduler(GxEPD2_Display& display, uint16_t min_interval_ms) :
+      _display(display), _interval(min_interval_ms), _batch(max_updates), _count(0), _last(0), _refreshed(false)
+    {
+      resetMetrics();
+    }
+    // limit the number of updates per refresh slot, the highest priority and earliest deadline go first
+    void setBatchLimit(uint8_t max_batch)
+    {
+      _batch = max_batch == 0 ? 1 : max_batch < max_updates ? max_batch : max_updates;
+    }
+    // queue an update of region x, y, w, h (display coordinates), already drawn to the buffer
+    // id : same id replaces the pending update (union of both regions)
+    // max_delay_ms : dropped if not shown within this time, 0 : no deadline
+    void update(uint8_t id, int16_t x, int16_t y, int16_t w, int16_t h, uint8_t priority = 0, uint32_t max_delay_ms = 0)
+    {
+      if ((w <= 0) || (h <= 0)) return;
+      if ((x + w <= 0) || (y + h <= 0)) return; // offscreen
+      _metrics.submitted++;
+      Entry e;
+      e.id = id;
+      e.region.x = x < 0 ? 0 : x;
+      e.region.y = y < 0 ? 0 : y;
+      e.region.w = x + w - e.region.x;
+      e.region.h = y + h - e.region.y;
+      e.priority = priority;
+      e.has_deadline = max_delay_ms > 0;
+      e.deadline = millis() + max_delay_ms;
+      for (uint8_t i = 0; i < _count; i++)
+      {
+        if (_entries[i].id == id)
+        {
+          _metrics.superseded++;
+          _entries[i] = _combined(_entries[i], e, id);
+          return;
+        }
+      }
+      if (_count < max_updates)
+      {
+        _entries[_count++] = e;
+        return;
+      }
+      // queue full, merge into the update with the least area growth
+      uint8_t best = 0;
+      uint32_t best_growth = 0xFFFFFFFF;
+      for (uint8_t i = 0; i < _count; i++)
+      {
+        uint32_t growth = _area(_combined(_entries[i], e, id).region) - _area(_entries[i].region);
+        if (growth < best_growth)
+        {
+          best = i;
+          best_growth = growth;
+        }
+      }
+      _metrics.merged++;
+      _entries[best] = _combined(_entries[best], e, _entries[best].id);
+    }
+    // refresh pending updates if a refresh slot is available; returns true if a refresh was done
+    bool loop()
+    {
+      uint32_t now = millis();
+      if (_refreshed && (now - _last < _interval)) return false;
+      _dropExpired(now);
+      if (_count == 0) return false;
+      _sort();
+      uint8_t n = _count < _batch ? _count : _batch;
+      GxEPD2_Region regions[max_updates];
+      for (uint8_t i = 0; i < n; i++)
+      {
+        regions[i] = _entries[i].region;
+      }
+      for (uint8_t i = n; i < _count; i++)
+      {
+        _entries[i - n] = _entries[i];
+      }
+      _count -= n;
+      _last = now;
+      _refreshed = true;
+      _metrics.refreshes++;
+      _metrics.batched += n - 1;
+      _display.displayRegions(regions, n);
+      return true;
+    }
+    // ms until the next refresh slot, 0 if available now
+    uint32_t nextSlot()
+    {
+      uint32_t elapsed = millis() - _last;
+      return (!_refreshed || (elapsed >= _interval)) ? 0 : _interval - elapsed;
+    }
+    uint8_t pending()
+    {
+      return _count;
+    }
+    void clear()
+    {
+      _count = 0;
+    }
+    const GxEPD2_UpdateMetrics& metrics()
+    {
+      return _metrics;
+    }
+    void resetMetrics()
+    {
+      _metrics.submitted = 0;
+      _metrics.superseded = 0;
+      _metrics.expired = 0;
+      _metrics.merged = 0;
+      _metrics.batched = 0;
+      _metrics.refreshes = 0;
+    }
+  private:
+    struct Entry
+    {
+      GxEPD2_Region region;
+      uint32_t deadline;
+      uint8_t id, priority;
+      bool has_deadline;
+    };
+    static uint32_t _area(const GxEPD2_Region& r)
+    {
+      return uint32_t(r.w) * uint32_t(r.h);
+    }
+    // deadline a before deadline b, wrap around safe
+    static bool _earlier(const Entry& a, const Entry& b)
+    {
+      if (!a.has_deadline) return false;
+      if (!b.has_deadline) return true;
+      return int32_t(a.deadline - b.deadline) < 0;
+    }
+    static Entry _combined(const Entry& a, const Entry& b, uint8_t id)
+    {
+      Entry c;
+      c.id = id;
+      c.region.x = a.region.x < b.region.x ? a.region.x : b.region.x;
+      c.region.y = a.region.y < b.region.y ? a.region.y : b.region.y;
+      c.region.w = (a.region.x + a.region.w > b.region.x + b.region.w ? a.region.x + a.region.w : b.region.x + b.region.w) - c.region.x;
+      c.region.h = (a.region.y + a.region.h > b.region.y + b.region.h ? a.region.y + a.region.h : b.region.y + b.region.h) - c.region.y;
+      c.priority = a.priority > b.priority ? a.priority : b.priority;
+      const Entry& d = _earlier(a, b) ? a : b;
+      c.has_deadline = d.has_deadline;
+      c.deadline = d.deadline;
+      return c;
+    }
+    void _dropExpired(uint32_t now)
+    {
+      uint8_t n = 0;
+      for (uint8_t i = 0; i < _count; i++)
+      {
+        if (_entries[i].has_deadline && (int32_t(now - _entries[i].deadline) > 0))
+        {
+          _metrics.expired++;
+          continue;
+        }
+        _entries[n++] = _entries[i];
+      }
+      _count = n;
+    }
+    // highest priority first, then earliest deadline; stable, keeps submission order otherwise
+    void _sort()
+    {
+      for (uint8_t i = 1; i < _count; i++)
+      {
+        Entry e = _entries[i];
+        uint8_t j = i;
+        for (; j > 0; j--)
+        {
+          const Entry& p = _entries[j - 1];
+          if ((e.priority < p.priority) || ((e.priority == p.priority) && !_earlier(e, p))) break;
+          _entries[j] = p;
+        }
+        _entries[j] = e;
+      }
+    }
+  private:
+    GxEPD2_Display& _display;
+    uint16_t _interval;
+    uint8_t _batch, _count;
+    uint32_t _last;
+    bool _refreshed;
+    Entry _entries[max_updates];
+    GxEPD2_UpdateMetrics _metrics;
+};
+
+#endif
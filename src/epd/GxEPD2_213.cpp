@@ -12,9 +12,12 @@
 #include "GxEPD2_213.h"
 #include "WaveTables.h"
 
+static const GxEPD2_EPD::LutRegister GxEPD2_213_lut_registers[] = {{0x32, 30}};
+
 GxEPD2_213::GxEPD2_213(int8_t cs, int8_t dc, int8_t rst, int8_t busy) :
   GxEPD2_EPD(cs, dc, rst, busy, HIGH, 10000000, WIDTH, HEIGHT, panel, hasColor, hasPartialUpdate, hasFastPartialUpdate)
 {
+  _setLutRegisters(GxEPD2_213_lut_registers, 1);
   _initial = true;
   _power_is_on = false;
   _using_partial_mode = false;
@@ -104,7 +107,7 @@ void GxEPD2_213::writeImage(const uint8_t bitmap[], int16_t x, int16_t y, int16_
     {
       uint8_t data;
       // use wb, h of bitmap for index!
-      int16_t idx = mirror_y ? j + dx / 8 + (h - 1 - i) * wb : j + dx / 8 + i * wb;
+      int16_t idx = mirror_y ? j + dx / 8 + ((h - 1 - (i + dy))) * wb : j + dx / 8 + (i + dy) * wb;
       if (pgm)
       {
 #if defined(__AVR) || defined(ESP8266) || defined(ESP32)
@@ -118,7 +121,7 @@ void GxEPD2_213::writeImage(const uint8_t bitmap[], int16_t x, int16_t y, int16_
         data = bitmap[idx];
       }
       if (invert) data = ~data;
-      else _writeData(data);
+      _writeData(data);
     }
   }
   delay(1); // yield() to avoid WDT on ESP8266 and ESP32
@@ -191,20 +194,20 @@ void GxEPD2_213::powerOff(void)
 void GxEPD2_213::_setPartialRamArea(uint16_t x, uint16_t y, uint16_t w, uint16_t h)
 {
   _writeCommand(0x11); // set ram entry mode
-  _writeData(0x01);    // x increase, y decrease : as in demo code
+  _writeData(0x03);    // x increase, y increase : rows in bitmap order, no reversed buffer needed
   _writeCommand(0x44);
   _writeData(x / 8);
   _writeData((x + w - 1) / 8);
   _writeCommand(0x45);
-  _writeData((y + h - 1) % 256);
-  _writeData((y + h - 1) / 256);
   _writeData(y % 256);
   _writeData(y / 256);
+  _writeData((y + h - 1) % 256);
+  _writeData((y + h - 1) / 256);
   _writeCommand(0x4e);
   _writeData(x / 8);
   _writeCommand(0x4f);
-  _writeData((y + h - 1) % 256);
-  _writeData((y + h - 1) / 256);
+  _writeData(y % 256);
+  _writeData(y / 256);
 }
 
 void GxEPD2_213::_PowerOn()
@@ -251,7 +254,7 @@ void GxEPD2_213::_InitDisplay()
 void GxEPD2_213::_Init_Full()
 {
   _InitDisplay();
-  _writeCommandDataPGM(GxGDE0213B1_LUTDefault_full, sizeof(GxGDE0213B1_LUTDefault_full));
+  _writeLut(false);
   _PowerOn();
   _using_partial_mode = false;
 }
@@ -259,13 +262,21 @@ void GxEPD2_213::_Init_Full()
 void GxEPD2_213::_Init_Part()
 {
   _InitDisplay();
-  _writeCommandDataPGM(GxGDE0213B1_LUTDefault_part, sizeof(GxGDE0213B1_LUTDefault_part));
+  _writeLut(true);
   _PowerOn();
   _using_partial_mode = true;
 }
 
+void GxEPD2_213::_writeLut(bool partial_refresh)
+{
+  if (!_updateLut(partial_refresh)) return; // custom LUT uploaded, or resident
+  if (partial_refresh) _writeCommandDataPGM(GxGDE0213B1_LUTDefault_part, sizeof(GxGDE0213B1_LUTDefault_part));
+  else _writeCommandDataPGM(GxGDE0213B1_LUTDefault_full, sizeof(GxGDE0213B1_LUTDefault_full));
+}
+
 void GxEPD2_213::_Update_Full()
 {
+  _writeLut(false);
   _writeCommand(0x22);
   _writeData(0xc4);
   _writeCommand(0x20);
@@ -275,6 +286,7 @@ void GxEPD2_213::_Update_Full()
 
 void GxEPD2_213::_Update_Part()
 {
+  _writeLut(true);
   _writeCommand(0x22);
   _writeData(0x04);
   _writeCommand(0x20);
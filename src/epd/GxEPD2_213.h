@@ -24,6 +24,7 @@ class GxEPD2_213 : public GxEPD2_EPD
     static const bool hasColor = false;
     static const bool hasPartialUpdate = true;
     static const bool hasFastPartialUpdate = true;
+    static const bool hasDualRamWrite = false;
     static const uint16_t power_on_time = 80; // ms, e.g. 72961us
     static const uint16_t power_off_time = 140; // ms, e.g. 135839us
     static const uint16_t full_refresh_time = 4000; // ms, e.g. 3883686us
@@ -57,6 +58,7 @@ class GxEPD2_213 : public GxEPD2_EPD
     void _PowerOn();
     void _PowerOff();
     void _InitDisplay();
+    void _writeLut(bool partial_refresh);
     void _Init_Full();
     void _Init_Part();
     void _Update_Full();
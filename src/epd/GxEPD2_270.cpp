@@ -12,12 +12,16 @@
 #include "GxEPD2_270.h"
 #include "WaveTables.h"
 
+static const GxEPD2_EPD::LutRegister GxEPD2_270_lut_registers[] = {{0x20, 44}, {0x21, 42}, {0x22, 42}, {0x23, 42}, {0x24, 42}};
+
 GxEPD2_270::GxEPD2_270(int8_t cs, int8_t dc, int8_t rst, int8_t busy) :
   GxEPD2_EPD(cs, dc, rst, busy, LOW, 10000000, WIDTH, HEIGHT, panel, hasColor, hasPartialUpdate, hasFastPartialUpdate)
 {
+  _setLutRegisters(GxEPD2_270_lut_registers, 5);
   _initial = true;
   _power_is_on = false;
   _using_partial_mode = false;
+  _grey_refreshed = false;
 }
 
 void GxEPD2_270::init(uint32_t serial_diag_bitrate)
@@ -26,12 +30,18 @@ void GxEPD2_270::init(uint32_t serial_diag_bitrate)
   _initial = true;
   _power_is_on = false;
   _using_partial_mode = false;
+  _grey_refreshed = false;
 }
 
 void GxEPD2_270::clearScreen(uint8_t value)
 {
   _Init_Part();
-  _setPartialRamArea(0, 0, WIDTH, HEIGHT);
+  _setPartialRamArea(0x14, 0, 0, WIDTH, HEIGHT); // old data, for refreshFast()
+  for (uint32_t i = 0; i < uint32_t(WIDTH) * uint32_t(HEIGHT) / 8; i++)
+  {
+    _writeData(value);
+  }
+  _setPartialRamArea(0x15, 0, 0, WIDTH, HEIGHT);
   for (uint32_t i = 0; i < uint32_t(WIDTH) * uint32_t(HEIGHT) / 8; i++)
   {
     _writeData(value);
@@ -39,6 +49,7 @@ void GxEPD2_270::clearScreen(uint8_t value)
   _refreshWindow(0, 0, WIDTH, HEIGHT);
   _waitWhileBusy("clearScreen", full_refresh_time);
   _initial = false;
+  _grey_refreshed = false; // old data rewritten
 }
 
 void GxEPD2_270::writeScreenBuffer(uint8_t value)
@@ -52,7 +63,7 @@ void GxEPD2_270::_writeScreenBuffer(uint8_t value)
 {
   _Init_Part();
   _writeCommand(0x91); // partial in
-  _setPartialRamArea(0, 0, WIDTH, HEIGHT);
+  _setPartialRamArea(0x15, 0, 0, WIDTH, HEIGHT);
   for (uint32_t i = 0; i < uint32_t(WIDTH) * uint32_t(HEIGHT) / 8; i++)
   {
     _writeData(value);
@@ -61,6 +72,16 @@ void GxEPD2_270::_writeScreenBuffer(uint8_t value)
 }
 
 void GxEPD2_270::writeImage(const uint8_t bitmap[], int16_t x, int16_t y, int16_t w, int16_t h, bool invert, bool mirror_y, bool pgm)
+{
+  _writeImage(0x15, bitmap, x, y, w, h, invert, mirror_y, pgm);
+}
+
+void GxEPD2_270::writeImageAgain(const uint8_t bitmap[], int16_t x, int16_t y, int16_t w, int16_t h, bool invert, bool mirror_y, bool pgm)
+{
+  _writeImage(0x14, bitmap, x, y, w, h, invert, mirror_y, pgm);
+}
+
+void GxEPD2_270::_writeImage(uint8_t command, const uint8_t bitmap[], int16_t x, int16_t y, int16_t w, int16_t h, bool invert, bool mirror_y, bool pgm)
 {
   delay(1); // yield() to avoid WDT on ESP8266 and ESP32
   int16_t wb = (w + 7) / 8; // width bytes, bitmaps are padded
@@ -76,7 +97,7 @@ void GxEPD2_270::writeImage(const uint8_t bitmap[], int16_t x, int16_t y, int16_
   h1 -= dy;
   if ((w1 <= 0) || (h1 <= 0)) return;
   if (!_using_partial_mode) _Init_Part();
-  _setPartialRamArea(x1, y1, w1, h1);
+  _setPartialRamArea(command, x1, y1, w1, h1);
   for (int16_t i = 0; i < h1; i++)
   {
     for (int16_t j = 0; j < w1 / 8; j++)
@@ -97,7 +118,7 @@ void GxEPD2_270::writeImage(const uint8_t bitmap[], int16_t x, int16_t y, int16_
         data = bitmap[idx];
       }
       if (invert) data = ~data;
-      else _writeData(data);
+      _writeData(data);
     }
   }
   delay(1); // yield() to avoid WDT on ESP8266 and ESP32
@@ -144,6 +165,7 @@ void GxEPD2_270::refresh(bool partial_update_mode)
   {
     if (_using_partial_mode) _Init_Full();
     _Update_Full();
+    _grey_refreshed = false;
   }
 }
 
@@ -157,19 +179,108 @@ void GxEPD2_270::refresh(int16_t x, int16_t y, int16_t w, int16_t h)
   int16_t h1 = y + h < int16_t(HEIGHT) ? h : int16_t(HEIGHT) - y; // limit
   w1 -= x1 - x;
   h1 -= y1 - y;
+  _writeLut(false);
   _refreshWindow(x1, y1, w1, h1);
   _waitWhileBusy("refresh", full_refresh_time);
 }
 
+void GxEPD2_270::refreshFast(int16_t x, int16_t y, int16_t w, int16_t h)
+{
+  if (_grey_refreshed) return refresh(false); // differential waveform needs B/W old data
+  w += x % 8; // byte boundary
+  x -= x % 8; // byte boundary
+  int16_t x1 = x < 0 ? 0 : x; // limit
+  int16_t y1 = y < 0 ? 0 : y; // limit
+  int16_t w1 = x + w < int16_t(WIDTH) ? w : int16_t(WIDTH) - x; // limit
+  int16_t h1 = y + h < int16_t(HEIGHT) ? h : int16_t(HEIGHT) - y; // limit
+  w1 -= x1 - x;
+  h1 -= y1 - y;
+  if (!_using_partial_mode) _Init_Part();
+  _writeLut(true);
+  _refreshWindow(x1, y1, w1, h1);
+  _waitWhileBusy("refreshFast", fast_refresh_time);
+}
+
+void GxEPD2_270::writeImage4G(const uint8_t bitmap[], int16_t x, int16_t y, int16_t w, int16_t h, bool invert, bool mirror_y, bool pgm)
+{
+  delay(1); // yield() to avoid WDT on ESP8266 and ESP32
+  int16_t wb = (w + 7) / 8; // bitmaps are padded to 8 pixels, 2 bytes
+  x -= x % 8; // byte boundary
+  w = wb * 8; // byte boundary
+  int16_t x1 = x < 0 ? 0 : x; // limit
+  int16_t y1 = y < 0 ? 0 : y; // limit
+  int16_t w1 = x + w < int16_t(WIDTH) ? w : int16_t(WIDTH) - x; // limit
+  int16_t h1 = y + h < int16_t(HEIGHT) ? h : int16_t(HEIGHT) - y; // limit
+  int16_t dx = x1 - x;
+  int16_t dy = y1 - y;
+  w1 -= dx;
+  h1 -= dy;
+  if ((w1 <= 0) || (h1 <= 0)) return;
+  if (!_using_partial_mode) _Init_Part();
+  for (uint8_t plane = 0; plane < 2; plane++)
+  {
+    _setPartialRamArea(plane ? 0x15 : 0x14, x1, y1, w1, h1); // high bit of grey level to old data, low bit to new data
+    for (int16_t i = 0; i < h1; i++)
+    {
+      for (int16_t j = 0; j < w1 / 8; j++)
+      {
+        // use wb, h of bitmap for index!
+        int32_t idx = 2 * int32_t(mirror_y ? j + dx / 8 + ((h - 1 - (i + dy))) * wb : j + dx / 8 + (i + dy) * wb);
+        uint8_t data = 0;
+        for (uint8_t k = 0; k < 2; k++)
+        {
+          uint8_t grey;
+          if (pgm)
+          {
+#if defined(__AVR) || defined(ESP8266) || defined(ESP32)
+            grey = pgm_read_byte(&bitmap[idx + k]);
+#else
+            grey = bitmap[idx + k];
+#endif
+          }
+          else
+          {
+            grey = bitmap[idx + k];
+          }
+          if (invert) grey = ~grey;
+          for (uint8_t p = 0; p < 4; p++)
+          {
+            data = (data << 1) | ((grey >> (7 - 2 * p - plane)) & 0x01);
+          }
+        }
+        _writeData(data);
+      }
+    }
+  }
+  delay(1); // yield() to avoid WDT on ESP8266 and ESP32
+}
+
+void GxEPD2_270::refresh4G(int16_t x, int16_t y, int16_t w, int16_t h)
+{
+  w += x % 8; // byte boundary
+  x -= x % 8; // byte boundary
+  int16_t x1 = x < 0 ? 0 : x; // limit
+  int16_t y1 = y < 0 ? 0 : y; // limit
+  int16_t w1 = x + w < int16_t(WIDTH) ? w : int16_t(WIDTH) - x; // limit
+  int16_t h1 = y + h < int16_t(HEIGHT) ? h : int16_t(HEIGHT) - y; // limit
+  w1 -= x1 - x;
+  h1 -= y1 - y;
+  if (!_using_partial_mode) _Init_Part();
+  _writeLut4G();
+  _refreshWindow(x1, y1, w1, h1);
+  _waitWhileBusy("refresh4G", grey_refresh_time);
+  _grey_refreshed = true;
+}
+
 void GxEPD2_270::powerOff(void)
 {
   _PowerOff();
 }
 
-void GxEPD2_270::_setPartialRamArea(uint16_t x, uint16_t y, uint16_t w, uint16_t h)
+void GxEPD2_270::_setPartialRamArea(uint8_t command, uint16_t x, uint16_t y, uint16_t w, uint16_t h)
 {
   w = (w + 7 + (x % 8)) & 0xfff8; // byte boundary exclusive (round up)
-  _writeCommand(0x15);
+  _writeCommand(command); // 0x14 old data, 0x15 new data
   _writeData(x >> 8);
   _writeData(x & 0xf8);
   _writeData(y >> 8);
@@ -263,19 +374,26 @@ void GxEPD2_270::_InitDisplay()
   _writeData (0x12);
 }
 
-void GxEPD2_270::_Init_Full()
+void GxEPD2_270::_writeLut4G()
 {
-  _InitDisplay();
+  // waveform of GDEW042T2, same LUT register layout
+  _resident_lut = 0; // B/W LUT gets uploaded again for the next B/W refresh
   _writeCommand(0x20);
-  _writeDataPGM(GxGDEW027W3_lut_20_vcomDC, sizeof(GxGDEW027W3_lut_20_vcomDC));
+  _writeDataPGM(GxGDEW042T2_lut_20_vcom0_4G, sizeof(GxGDEW042T2_lut_20_vcom0_4G));
   _writeCommand(0x21);
-  _writeDataPGM(GxGDEW027W3_lut_21_ww, sizeof(GxGDEW027W3_lut_21_ww));
+  _writeDataPGM(GxGDEW042T2_lut_21_ww_4G, sizeof(GxGDEW042T2_lut_21_ww_4G));
   _writeCommand(0x22);
-  _writeDataPGM(GxGDEW027W3_lut_22_bw, sizeof(GxGDEW027W3_lut_22_bw));
+  _writeDataPGM(GxGDEW042T2_lut_22_bw_4G, sizeof(GxGDEW042T2_lut_22_bw_4G));
   _writeCommand(0x23);
-  _writeDataPGM(GxGDEW027W3_lut_23_wb, sizeof(GxGDEW027W3_lut_23_wb));
+  _writeDataPGM(GxGDEW042T2_lut_23_wb_4G, sizeof(GxGDEW042T2_lut_23_wb_4G));
   _writeCommand(0x24);
-  _writeDataPGM(GxGDEW027W3_lut_24_bb, sizeof(GxGDEW027W3_lut_24_bb));
+  _writeDataPGM(GxGDEW042T2_lut_24_bb_4G, sizeof(GxGDEW042T2_lut_24_bb_4G));
+}
+
+void GxEPD2_270::_Init_Full()
+{
+  _InitDisplay();
+  _writeLut(false);
   _PowerOn();
   _using_partial_mode = false;
 }
@@ -283,7 +401,30 @@ void GxEPD2_270::_Init_Full()
 void GxEPD2_270::_Init_Part()
 {
   _InitDisplay();
-  // no partial update LUT
+  _writeLut(false);
+  _PowerOn();
+  _using_partial_mode = true;
+}
+
+void GxEPD2_270::_writeLut(bool partial_refresh)
+{
+  if (!_updateLut(partial_refresh)) return; // custom LUT uploaded, or resident
+  if (partial_refresh)
+  {
+    // differential, for refreshFast()
+    _writeCommand(0x20);
+    _writeDataPGM(GxGDEW027W3_lut_20_vcomDC_partial, sizeof(GxGDEW027W3_lut_20_vcomDC_partial));
+    _writeCommand(0x21);
+    _writeDataPGM(GxGDEW027W3_lut_21_ww_partial, sizeof(GxGDEW027W3_lut_21_ww_partial));
+    _writeCommand(0x22);
+    _writeDataPGM(GxGDEW027W3_lut_22_bw_partial, sizeof(GxGDEW027W3_lut_22_bw_partial));
+    _writeCommand(0x23);
+    _writeDataPGM(GxGDEW027W3_lut_23_wb_partial, sizeof(GxGDEW027W3_lut_23_wb_partial));
+    _writeCommand(0x24);
+    _writeDataPGM(GxGDEW027W3_lut_24_bb_partial, sizeof(GxGDEW027W3_lut_24_bb_partial));
+    return;
+  }
+  // same LUT for full and partial refresh
   _writeCommand(0x20);
   _writeDataPGM(GxGDEW027W3_lut_20_vcomDC, sizeof(GxGDEW027W3_lut_20_vcomDC));
   _writeCommand(0x21);
@@ -294,18 +435,18 @@ void GxEPD2_270::_Init_Part()
   _writeDataPGM(GxGDEW027W3_lut_23_wb, sizeof(GxGDEW027W3_lut_23_wb));
   _writeCommand(0x24);
   _writeDataPGM(GxGDEW027W3_lut_24_bb, sizeof(GxGDEW027W3_lut_24_bb));
-  _PowerOn();
-  _using_partial_mode = true;
 }
 
 void GxEPD2_270::_Update_Full()
 {
+  _writeLut(false);
   _writeCommand(0x12); //display refresh
   _waitWhileBusy("_Update_Full", full_refresh_time);
 }
 
 void GxEPD2_270::_Update_Part()
 {
+  _writeLut(false);
   _writeCommand(0x12); //display refresh
   _waitWhileBusy("_Update_Part", full_refresh_time);
 }
@@ -24,10 +24,13 @@ class GxEPD2_270 : public GxEPD2_EPD
     static const bool hasColor = false;
     static const bool hasPartialUpdate = true;
     static const bool hasFastPartialUpdate = false;
+    static const bool hasDualRamWrite = false;
     static const uint16_t power_on_time = 100; // ms, e.g. 98877us
     static const uint16_t power_off_time = 30; // ms, e.g. 28405us
     static const uint16_t full_refresh_time = 4000; // ms, e.g. 3776419us
     static const uint16_t partial_refresh_time = 4000; // ms, e.g. 3776419us
+    static const uint16_t fast_refresh_time = 300; // ms, refreshFast(), 25 frames at 100Hz
+    static const uint16_t grey_refresh_time = 4000; // ms, refresh4G(), estimate
     // constructor
     GxEPD2_270(int8_t cs, int8_t dc, int8_t rst, int8_t busy);
     // methods (virtual)
@@ -47,20 +50,35 @@ class GxEPD2_270 : public GxEPD2_EPD
     void drawNative(const uint8_t* data1, const uint8_t* data2, int16_t x, int16_t y, int16_t w, int16_t h, bool invert = false, bool mirror_y = false, bool pgm = false);
     void refresh(bool partial_update_mode = false); // screen refresh from controller memory to full screen
     void refresh(int16_t x, int16_t y, int16_t w, int16_t h); // screen refresh from controller memory, partial screen
+    // fast differential partial refresh, drives only pixels that differ between old and new data
+    // old data must match the screen: use writeImageAgain() with the same content after each refresh
+    void refreshFast(int16_t x, int16_t y, int16_t w, int16_t h);
+    // write to old data controller memory, for refreshFast(); x and w should be multiple of 8
+    void writeImageAgain(const uint8_t bitmap[], int16_t x, int16_t y, int16_t w, int16_t h, bool invert = false, bool mirror_y = false, bool pgm = false);
+    // write 4 grey levels to controller memory, for GxEPD2_4G; x and w should be multiple of 8
+    // 2bpp bitmap, 4 pixels per byte msb first, 0 black, 1 dark grey, 2 light grey, 3 white
+    void writeImage4G(const uint8_t bitmap[], int16_t x, int16_t y, int16_t w, int16_t h, bool invert = false, bool mirror_y = false, bool pgm = false);
+    // screen refresh with grey level waveform; the old data memory then holds a grey level plane,
+    // so the next B/W refresh is done as full refresh, refreshFast() included
+    void refresh4G(int16_t x, int16_t y, int16_t w, int16_t h);
     void powerOff();
   private:
     void _writeScreenBuffer(uint8_t value);
-    void _setPartialRamArea(uint16_t x, uint16_t y, uint16_t w, uint16_t h);
+    void _writeImage(uint8_t command, const uint8_t bitmap[], int16_t x, int16_t y, int16_t w, int16_t h, bool invert, bool mirror_y, bool pgm);
+    void _setPartialRamArea(uint8_t command, uint16_t x, uint16_t y, uint16_t w, uint16_t h);
     void _refreshWindow(uint16_t x, uint16_t y, uint16_t w, uint16_t h);
     void _PowerOn();
     void _PowerOff();
     void _InitDisplay();
+    void _writeLut(bool partial_refresh);
+    void _writeLut4G();
     void _Init_Full();
     void _Init_Part();
     void _Update_Full();
     void _Update_Part();
   protected:
     bool _initial, _power_is_on, _using_partial_mode;
+    bool _grey_refreshed; // old data memory holds a grey level plane, not the screen content
 };
 
 #endif
@@ -12,9 +12,12 @@
 #include "GxEPD2_290.h"
 #include "WaveTables.h"
 
+static const GxEPD2_EPD::LutRegister GxEPD2_290_lut_registers[] = {{0x32, 30}};
+
 GxEPD2_290::GxEPD2_290(int8_t cs, int8_t dc, int8_t rst, int8_t busy) :
   GxEPD2_EPD(cs, dc, rst, busy, HIGH, 10000000, WIDTH, HEIGHT, panel, hasColor, hasPartialUpdate, hasFastPartialUpdate)
 {
+  _setLutRegisters(GxEPD2_290_lut_registers, 1);
   _initial = true;
   _power_is_on = false;
   _using_partial_mode = false;
@@ -118,7 +121,7 @@ void GxEPD2_290::writeImage(const uint8_t bitmap[], int16_t x, int16_t y, int16_
         data = bitmap[idx];
       }
       if (invert) data = ~data;
-      else _writeData(data);
+      _writeData(data);
     }
   }
   delay(1); // yield() to avoid WDT on ESP8266 and ESP32
@@ -251,7 +254,7 @@ void GxEPD2_290::_InitDisplay()
 void GxEPD2_290::_Init_Full()
 {
   _InitDisplay();
-  _writeCommandDataPGM(GxGDEH029A1_LUTDefault_full, sizeof(GxGDEH029A1_LUTDefault_full));
+  _writeLut(false);
   _PowerOn();
   _using_partial_mode = false;
 }
@@ -259,13 +262,21 @@ void GxEPD2_290::_Init_Full()
 void GxEPD2_290::_Init_Part()
 {
   _InitDisplay();
-  _writeCommandDataPGM(GxGDEH029A1_LUTDefault_part, sizeof(GxGDEH029A1_LUTDefault_part));
+  _writeLut(true);
   _PowerOn();
   _using_partial_mode = true;
 }
 
+void GxEPD2_290::_writeLut(bool partial_refresh)
+{
+  if (!_updateLut(partial_refresh)) return; // custom LUT uploaded, or resident
+  if (partial_refresh) _writeCommandDataPGM(GxGDEH029A1_LUTDefault_part, sizeof(GxGDEH029A1_LUTDefault_part));
+  else _writeCommandDataPGM(GxGDEH029A1_LUTDefault_full, sizeof(GxGDEH029A1_LUTDefault_full));
+}
+
 void GxEPD2_290::_Update_Full()
 {
+  _writeLut(false);
   _writeCommand(0x22);
   _writeData(0xc4);
   _writeCommand(0x20);
@@ -275,6 +286,7 @@ void GxEPD2_290::_Update_Full()
 
 void GxEPD2_290::_Update_Part()
 {
+  _writeLut(true);
   _writeCommand(0x22);
   _writeData(0x04);
   _writeCommand(0x20);
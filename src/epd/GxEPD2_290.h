@@ -24,6 +24,7 @@ class GxEPD2_290 : public GxEPD2_EPD
     static const bool hasColor = false;
     static const bool hasPartialUpdate = true;
     static const bool hasFastPartialUpdate = true;
+    static const bool hasDualRamWrite = false;
     static const uint16_t power_on_time = 80; // ms, e.g. 72498us
     static const uint16_t power_off_time = 100; // ms, e.g. 93329us
     static const uint16_t full_refresh_time = 1600; // ms, e.g. 1575016us
@@ -54,6 +55,7 @@ class GxEPD2_290 : public GxEPD2_EPD
     void _PowerOn();
     void _PowerOff();
     void _InitDisplay();
+    void _writeLut(bool partial_refresh);
     void _Init_Full();
     void _Init_Part();
     void _Update_Full();
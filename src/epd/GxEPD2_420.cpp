@@ -12,12 +12,16 @@
 #include "GxEPD2_420.h"
 #include "WaveTables.h"
 
+static const GxEPD2_EPD::LutRegister GxEPD2_420_lut_registers[] = {{0x20, 44}, {0x21, 42}, {0x22, 42}, {0x23, 42}, {0x24, 42}};
+
 GxEPD2_420::GxEPD2_420(int8_t cs, int8_t dc, int8_t rst, int8_t busy) :
   GxEPD2_EPD(cs, dc, rst, busy, LOW, 10000000, WIDTH, HEIGHT, panel, hasColor, hasPartialUpdate, hasFastPartialUpdate)
 {
+  _setLutRegisters(GxEPD2_420_lut_registers, 5);
   _initial = true;
   _power_is_on = false;
   _using_partial_mode = false;
+  _grey_refreshed = false;
 }
 
 void GxEPD2_420::init(uint32_t serial_diag_bitrate)
@@ -26,11 +30,12 @@ void GxEPD2_420::init(uint32_t serial_diag_bitrate)
   _initial = true;
   _power_is_on = false;
   _using_partial_mode = false;
+  _grey_refreshed = false;
 }
 
 void GxEPD2_420::clearScreen(uint8_t value)
 {
-  if (_initial)
+  if (_initial || _grey_refreshed)
   {
     _Init_Full();
     _writeCommand(0x13);
@@ -40,6 +45,7 @@ void GxEPD2_420::clearScreen(uint8_t value)
     }
     _Update_Full();
     _initial = false;
+    _grey_refreshed = false;
   }
   if (!_using_partial_mode) _Init_Part();
   _writeCommand(0x91); // partial in
@@ -81,6 +87,17 @@ void GxEPD2_420::_writeScreenBuffer(uint8_t value)
 }
 
 void GxEPD2_420::writeImage(const uint8_t bitmap[], int16_t x, int16_t y, int16_t w, int16_t h, bool invert, bool mirror_y, bool pgm)
+{
+  _writeImage(0x13, bitmap, x, y, w, h, invert, mirror_y, pgm);
+}
+
+void GxEPD2_420::writeImageDual(const uint8_t bitmap[], int16_t x, int16_t y, int16_t w, int16_t h, bool invert, bool mirror_y, bool pgm)
+{
+  _writeImage(0x10, bitmap, x, y, w, h, invert, mirror_y, pgm); // previous image, reference for differential refresh
+  _writeImage(0x13, bitmap, x, y, w, h, invert, mirror_y, pgm);
+}
+
+void GxEPD2_420::_writeImage(uint8_t command, const uint8_t bitmap[], int16_t x, int16_t y, int16_t w, int16_t h, bool invert, bool mirror_y, bool pgm)
 {
   delay(1); // yield() to avoid WDT on ESP8266 and ESP32
   int16_t wb = (w + 7) / 8; // width bytes, bitmaps are padded
@@ -98,7 +115,7 @@ void GxEPD2_420::writeImage(const uint8_t bitmap[], int16_t x, int16_t y, int16_
   if (!_using_partial_mode) _Init_Part();
   _writeCommand(0x91); // partial in
   _setPartialRamArea(x1, y1, w1, h1);
-  _writeCommand(0x13);
+  _writeCommand(command);
   for (int16_t i = 0; i < h1; i++)
   {
     for (int16_t j = 0; j < w1 / 8; j++)
@@ -167,11 +184,13 @@ void GxEPD2_420::refresh(bool partial_update_mode)
   {
     if (_using_partial_mode) _Init_Full();
     _Update_Full();
+    _grey_refreshed = false;
   }
 }
 
 void GxEPD2_420::refresh(int16_t x, int16_t y, int16_t w, int16_t h)
 {
+  if (_grey_refreshed) return refresh(false); // differential waveform needs B/W old data
   x -= x % 8; // byte boundary
   w -= x % 8; // byte boundary
   int16_t x1 = x < 0 ? 0 : x; // limit
@@ -187,6 +206,83 @@ void GxEPD2_420::refresh(int16_t x, int16_t y, int16_t w, int16_t h)
   _writeCommand(0x92); // partial out
 }
 
+void GxEPD2_420::writeImage4G(const uint8_t bitmap[], int16_t x, int16_t y, int16_t w, int16_t h, bool invert, bool mirror_y, bool pgm)
+{
+  delay(1); // yield() to avoid WDT on ESP8266 and ESP32
+  int16_t wb = (w + 7) / 8; // bitmaps are padded to 8 pixels, 2 bytes
+  x -= x % 8; // byte boundary
+  w = wb * 8; // byte boundary
+  int16_t x1 = x < 0 ? 0 : x; // limit
+  int16_t y1 = y < 0 ? 0 : y; // limit
+  int16_t w1 = x + w < int16_t(WIDTH) ? w : int16_t(WIDTH) - x; // limit
+  int16_t h1 = y + h < int16_t(HEIGHT) ? h : int16_t(HEIGHT) - y; // limit
+  int16_t dx = x1 - x;
+  int16_t dy = y1 - y;
+  w1 -= dx;
+  h1 -= dy;
+  if ((w1 <= 0) || (h1 <= 0)) return;
+  if (!_using_partial_mode) _Init_Part();
+  _writeCommand(0x91); // partial in
+  _setPartialRamArea(x1, y1, w1, h1);
+  for (uint8_t plane = 0; plane < 2; plane++)
+  {
+    _writeCommand(plane ? 0x13 : 0x10); // high bit of grey level to 0x10, low bit to 0x13
+    for (int16_t i = 0; i < h1; i++)
+    {
+      for (int16_t j = 0; j < w1 / 8; j++)
+      {
+        // use wb, h of bitmap for index!
+        int32_t idx = 2 * int32_t(mirror_y ? j + dx / 8 + ((h - 1 - (i + dy))) * wb : j + dx / 8 + (i + dy) * wb);
+        uint8_t data = 0;
+        for (uint8_t k = 0; k < 2; k++)
+        {
+          uint8_t grey;
+          if (pgm)
+          {
+#if defined(__AVR) || defined(ESP8266) || defined(ESP32)
+            grey = pgm_read_byte(&bitmap[idx + k]);
+#else
+            grey = bitmap[idx + k];
+#endif
+          }
+          else
+          {
+            grey = bitmap[idx + k];
+          }
+          if (invert) grey = ~grey;
+          for (uint8_t p = 0; p < 4; p++)
+          {
+            data = (data << 1) | ((grey >> (7 - 2 * p - plane)) & 0x01);
+          }
+        }
+        _writeData(data);
+      }
+    }
+  }
+  _writeCommand(0x92); // partial out
+  delay(1); // yield() to avoid WDT on ESP8266 and ESP32
+}
+
+void GxEPD2_420::refresh4G(int16_t x, int16_t y, int16_t w, int16_t h)
+{
+  w += x % 8; // byte boundary
+  x -= x % 8; // byte boundary
+  int16_t x1 = x < 0 ? 0 : x; // limit
+  int16_t y1 = y < 0 ? 0 : y; // limit
+  int16_t w1 = x + w < int16_t(WIDTH) ? w : int16_t(WIDTH) - x; // limit
+  int16_t h1 = y + h < int16_t(HEIGHT) ? h : int16_t(HEIGHT) - y; // limit
+  w1 -= x1 - x;
+  h1 -= y1 - y;
+  if (!_using_partial_mode) _Init_Part();
+  _writeLut4G();
+  _writeCommand(0x91); // partial in
+  _setPartialRamArea(x1, y1, w1, h1);
+  _writeCommand(0x12); //display refresh
+  _waitWhileBusy("refresh4G", grey_refresh_time);
+  _grey_refreshed = true;
+  _writeCommand(0x92); // partial out
+}
+
 void GxEPD2_420::powerOff(void)
 {
   _PowerOff();
@@ -239,19 +335,25 @@ void GxEPD2_420::_InitDisplay()
   _writeData(0x3F); //300x400 B/W mode, LUT set by register
 }
 
-void GxEPD2_420::_Init_Full()
+void GxEPD2_420::_writeLut4G()
 {
-  _InitDisplay();
+  _resident_lut = 0; // B/W LUT gets uploaded again for the next B/W refresh
   _writeCommand(0x20);
-  _writeDataPGM(GxGDEW042T2_lut_20_vcom0_full, sizeof(GxGDEW042T2_lut_20_vcom0_full));
+  _writeDataPGM(GxGDEW042T2_lut_20_vcom0_4G, sizeof(GxGDEW042T2_lut_20_vcom0_4G));
   _writeCommand(0x21);
-  _writeDataPGM(GxGDEW042T2_lut_21_ww_full, sizeof(GxGDEW042T2_lut_21_ww_full));
+  _writeDataPGM(GxGDEW042T2_lut_21_ww_4G, sizeof(GxGDEW042T2_lut_21_ww_4G));
   _writeCommand(0x22);
-  _writeDataPGM(GxGDEW042T2_lut_22_bw_full, sizeof(GxGDEW042T2_lut_22_bw_full));
+  _writeDataPGM(GxGDEW042T2_lut_22_bw_4G, sizeof(GxGDEW042T2_lut_22_bw_4G));
   _writeCommand(0x23);
-  _writeDataPGM(GxGDEW042T2_lut_23_wb_full, sizeof(GxGDEW042T2_lut_23_wb_full));
+  _writeDataPGM(GxGDEW042T2_lut_23_wb_4G, sizeof(GxGDEW042T2_lut_23_wb_4G));
   _writeCommand(0x24);
-  _writeDataPGM(GxGDEW042T2_lut_24_bb_full, sizeof(GxGDEW042T2_lut_24_bb_full));
+  _writeDataPGM(GxGDEW042T2_lut_24_bb_4G, sizeof(GxGDEW042T2_lut_24_bb_4G));
+}
+
+void GxEPD2_420::_Init_Full()
+{
+  _InitDisplay();
+  _writeLut(false);
   _PowerOn();
   _using_partial_mode = false;
 }
@@ -259,28 +361,52 @@ void GxEPD2_420::_Init_Full()
 void GxEPD2_420::_Init_Part()
 {
   _InitDisplay();
-  _writeCommand(0x20);
-  _writeDataPGM(GxGDEW042T2_lut_20_vcom0_partial, sizeof(GxGDEW042T2_lut_20_vcom0_partial));
-  _writeCommand(0x21);
-  _writeDataPGM(GxGDEW042T2_lut_21_ww_partial, sizeof(GxGDEW042T2_lut_21_ww_partial));
-  _writeCommand(0x22);
-  _writeDataPGM(GxGDEW042T2_lut_22_bw_partial, sizeof(GxGDEW042T2_lut_22_bw_partial));
-  _writeCommand(0x23);
-  _writeDataPGM(GxGDEW042T2_lut_23_wb_partial, sizeof(GxGDEW042T2_lut_23_wb_partial));
-  _writeCommand(0x24);
-  _writeDataPGM(GxGDEW042T2_lut_24_bb_partial, sizeof(GxGDEW042T2_lut_24_bb_partial));
+  _writeLut(true);
   _PowerOn();
   _using_partial_mode = true;
 }
 
+void GxEPD2_420::_writeLut(bool partial_refresh)
+{
+  if (!_updateLut(partial_refresh)) return; // custom LUT uploaded, or resident
+  if (partial_refresh)
+  {
+    _writeCommand(0x20);
+    _writeDataPGM(GxGDEW042T2_lut_20_vcom0_partial, sizeof(GxGDEW042T2_lut_20_vcom0_partial));
+    _writeCommand(0x21);
+    _writeDataPGM(GxGDEW042T2_lut_21_ww_partial, sizeof(GxGDEW042T2_lut_21_ww_partial));
+    _writeCommand(0x22);
+    _writeDataPGM(GxGDEW042T2_lut_22_bw_partial, sizeof(GxGDEW042T2_lut_22_bw_partial));
+    _writeCommand(0x23);
+    _writeDataPGM(GxGDEW042T2_lut_23_wb_partial, sizeof(GxGDEW042T2_lut_23_wb_partial));
+    _writeCommand(0x24);
+    _writeDataPGM(GxGDEW042T2_lut_24_bb_partial, sizeof(GxGDEW042T2_lut_24_bb_partial));
+  }
+  else
+  {
+    _writeCommand(0x20);
+    _writeDataPGM(GxGDEW042T2_lut_20_vcom0_full, sizeof(GxGDEW042T2_lut_20_vcom0_full));
+    _writeCommand(0x21);
+    _writeDataPGM(GxGDEW042T2_lut_21_ww_full, sizeof(GxGDEW042T2_lut_21_ww_full));
+    _writeCommand(0x22);
+    _writeDataPGM(GxGDEW042T2_lut_22_bw_full, sizeof(GxGDEW042T2_lut_22_bw_full));
+    _writeCommand(0x23);
+    _writeDataPGM(GxGDEW042T2_lut_23_wb_full, sizeof(GxGDEW042T2_lut_23_wb_full));
+    _writeCommand(0x24);
+    _writeDataPGM(GxGDEW042T2_lut_24_bb_full, sizeof(GxGDEW042T2_lut_24_bb_full));
+  }
+}
+
 void GxEPD2_420::_Update_Full()
 {
+  _writeLut(false);
   _writeCommand(0x12); //display refresh
   _waitWhileBusy("_Update_Full", full_refresh_time);
 }
 
 void GxEPD2_420::_Update_Part()
 {
+  _writeLut(true);
   _writeCommand(0x12); //display refresh
   _waitWhileBusy("_Update_Part", partial_refresh_time);
 }
@@ -24,10 +24,12 @@ class GxEPD2_420 : public GxEPD2_EPD
     static const bool hasColor = false;
     static const bool hasPartialUpdate = true;
     static const bool hasFastPartialUpdate = true;
+    static const bool hasDualRamWrite = true; // writeImageDual() writes previous and current image memory
     static const uint16_t power_on_time = 40; // ms, e.g. 36996us
     static const uint16_t power_off_time = 42; // ms, e.g. 40026us
     static const uint16_t full_refresh_time = 4200; // ms, e.g. 4108541us
     static const uint16_t partial_refresh_time = 1000; // ms, e.g. 995320us
+    static const uint16_t grey_refresh_time = 4000; // ms, refresh4G(), estimate
     // constructor
     GxEPD2_420(int8_t cs, int8_t dc, int8_t rst, int8_t busy);
     // methods (virtual)
@@ -38,6 +40,8 @@ class GxEPD2_420 : public GxEPD2_EPD
     // write to controller memory, without screen refresh; x and w should be multiple of 8
     void writeImage(const uint8_t bitmap[], int16_t x, int16_t y, int16_t w, int16_t h, bool invert = false, bool mirror_y = false, bool pgm = false);
     void writeImage(const uint8_t* black, const uint8_t* color, int16_t x, int16_t y, int16_t w, int16_t h, bool invert = false, bool mirror_y = false, bool pgm = false);
+    // write to both controller memories, previous and current image, for a full refresh before refreshFast()
+    void writeImageDual(const uint8_t bitmap[], int16_t x, int16_t y, int16_t w, int16_t h, bool invert = false, bool mirror_y = false, bool pgm = false);
     // write sprite of native data to controller memory, without screen refresh; x and w should be multiple of 8
     void writeNative(const uint8_t* data1, const uint8_t* data2, int16_t x, int16_t y, int16_t w, int16_t h, bool invert = false, bool mirror_y = false, bool pgm = false);
     // write to controller memory, with screen refresh; x and w should be multiple of 8
@@ -47,19 +51,29 @@ class GxEPD2_420 : public GxEPD2_EPD
     void drawNative(const uint8_t* data1, const uint8_t* data2, int16_t x, int16_t y, int16_t w, int16_t h, bool invert = false, bool mirror_y = false, bool pgm = false);
     void refresh(bool partial_update_mode = false); // screen refresh from controller memory to full screen
     void refresh(int16_t x, int16_t y, int16_t w, int16_t h); // screen refresh from controller memory, partial screen
+    // write 4 grey levels to controller memory, for GxEPD2_4G; x and w should be multiple of 8
+    // 2bpp bitmap, 4 pixels per byte msb first, 0 black, 1 dark grey, 2 light grey, 3 white
+    void writeImage4G(const uint8_t bitmap[], int16_t x, int16_t y, int16_t w, int16_t h, bool invert = false, bool mirror_y = false, bool pgm = false);
+    // screen refresh with grey level waveform; the old data memory then holds a grey level plane,
+    // so the next B/W refresh is done as full refresh
+    void refresh4G(int16_t x, int16_t y, int16_t w, int16_t h);
     void powerOff();
   private:
     void _writeScreenBuffer(uint8_t value);
+    void _writeImage(uint8_t command, const uint8_t bitmap[], int16_t x, int16_t y, int16_t w, int16_t h, bool invert, bool mirror_y, bool pgm);
     void _setPartialRamArea(uint16_t x, uint16_t y, uint16_t w, uint16_t h);
     void _PowerOn();
     void _PowerOff();
     void _InitDisplay();
+    void _writeLut(bool partial_refresh);
+    void _writeLut4G();
     void _Init_Full();
     void _Init_Part();
     void _Update_Full();
     void _Update_Part();
   protected:
     bool _initial, _power_is_on, _using_partial_mode;
+    bool _grey_refreshed; // old data memory holds a grey level plane, not the screen content
 };
 
 #endif
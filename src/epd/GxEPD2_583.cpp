@@ -230,6 +230,81 @@ void GxEPD2_583::refresh(int16_t x, int16_t y, int16_t w, int16_t h)
   _writeCommand(0x92); // partial out
 }
 
+void GxEPD2_583::refreshFast(int16_t x, int16_t y, int16_t w, int16_t h)
+{
+  w += x % 8; // byte boundary
+  x -= x % 8; // byte boundary
+  int16_t x1 = x < 0 ? 0 : x; // limit
+  int16_t y1 = y < 0 ? 0 : y; // limit
+  int16_t w1 = x + w < int16_t(WIDTH) ? w : int16_t(WIDTH) - x; // limit
+  int16_t h1 = y + h < int16_t(HEIGHT) ? h : int16_t(HEIGHT) - y; // limit
+  w1 -= x1 - x;
+  h1 -= y1 - y;
+  if (!_using_partial_mode) _Init_Part();
+  _writeCommand(0x30); // PLL setting
+  _writeData(0x39); // higher frame rate, OTP waveform runs faster
+  _writeCommand(0x91); // partial in
+  _setPartialRamArea(x1, y1, w1, h1);
+  _writeCommand(0x12); //display refresh
+  _waitWhileBusy("refreshFast", fast_refresh_time);
+  _writeCommand(0x92); // partial out
+  _writeCommand(0x30); // PLL setting
+  _writeData(0x3a); // back to normal frame rate
+}
+
+void GxEPD2_583::writeImage4G(const uint8_t bitmap[], int16_t x, int16_t y, int16_t w, int16_t h, bool invert, bool mirror_y, bool pgm)
+{
+  delay(1); // yield() to avoid WDT on ESP8266 and ESP32
+  int16_t wb = (w + 7) / 8; // bitmaps are padded to 8 pixels, 2 bytes
+  x -= x % 8; // byte boundary
+  w = wb * 8; // byte boundary
+  int16_t x1 = x < 0 ? 0 : x; // limit
+  int16_t y1 = y < 0 ? 0 : y; // limit
+  int16_t w1 = x + w < int16_t(WIDTH) ? w : int16_t(WIDTH) - x; // limit
+  int16_t h1 = y + h < int16_t(HEIGHT) ? h : int16_t(HEIGHT) - y; // limit
+  int16_t dx = x1 - x;
+  int16_t dy = y1 - y;
+  w1 -= dx;
+  h1 -= dy;
+  if ((w1 <= 0) || (h1 <= 0)) return;
+  if (!_using_partial_mode) _Init_Part();
+  _writeCommand(0x91); // partial in
+  _setPartialRamArea(x1, y1, w1, h1);
+  _writeCommand(0x10);
+  for (int16_t i = 0; i < h1; i++)
+  {
+    for (int16_t j = 0; j < w1 / 4; j++)
+    {
+      // use wb, h of bitmap for index!
+      int32_t idx = j + 2 * int32_t(mirror_y ? dx / 8 + ((h - 1 - (i + dy))) * wb : dx / 8 + (i + dy) * wb);
+      uint8_t grey;
+      if (pgm)
+      {
+#if defined(__AVR) || defined(ESP8266) || defined(ESP32)
+        grey = pgm_read_byte(&bitmap[idx]);
+#else
+        grey = bitmap[idx];
+#endif
+      }
+      else
+      {
+        grey = bitmap[idx];
+      }
+      if (invert) grey = ~grey;
+      // native pixel codes 0x0 black .. 0x3 white, 2 pixels per byte
+      _writeData(((grey & 0xC0) >> 2) | ((grey & 0x30) >> 4));
+      _writeData(((grey & 0x0C) << 2) | (grey & 0x03));
+    }
+  }
+  _writeCommand(0x92); // partial out
+  delay(1); // yield() to avoid WDT on ESP8266 and ESP32
+}
+
+void GxEPD2_583::refresh4G(int16_t x, int16_t y, int16_t w, int16_t h)
+{
+  refresh(x, y, w, h); // the OTP waveform has the grey levels
+}
+
 void GxEPD2_583::powerOff(void)
 {
   _PowerOff();
@@ -24,10 +24,13 @@ class GxEPD2_583 : public GxEPD2_EPD
     static const bool hasColor = false;
     static const bool hasPartialUpdate = true;
     static const bool hasFastPartialUpdate = false;
+    static const bool hasDualRamWrite = false;
     static const uint16_t power_on_time = 60; // ms, e.g. 56728us
     static const uint16_t power_off_time = 30; // ms, e.g. 20291us
     static const uint16_t full_refresh_time = 15000; // ms, e.g. 14598868us
     static const uint16_t partial_refresh_time = 15000; // ms, e.g. 14598868us
+    static const uint16_t fast_refresh_time = 7500; // ms, refreshFast(), 7s instead of 15s
+    static const uint16_t grey_refresh_time = 15000; // ms, refresh4G(), same as refresh()
     // constructor
     GxEPD2_583(int8_t cs, int8_t dc, int8_t rst, int8_t busy);
     // methods (virtual)
@@ -47,6 +50,12 @@ class GxEPD2_583 : public GxEPD2_EPD
     void drawNative(const uint8_t* data1, const uint8_t* data2, int16_t x, int16_t y, int16_t w, int16_t h, bool invert = false, bool mirror_y = false, bool pgm = false);
     void refresh(bool partial_update_mode = false); // screen refresh from controller memory to full screen
     void refresh(int16_t x, int16_t y, int16_t w, int16_t h); // screen refresh from controller memory, partial screen
+    // faster partial refresh with higher frame rate, OTP LUT; less contrast, use refresh() for cleanup
+    void refreshFast(int16_t x, int16_t y, int16_t w, int16_t h);
+    // write 4 grey levels to controller memory, for GxEPD2_4G; x and w should be multiple of 8
+    // 2bpp bitmap, 4 pixels per byte msb first, 0 black, 1 dark grey, 2 light grey, 3 white
+    void writeImage4G(const uint8_t bitmap[], int16_t x, int16_t y, int16_t w, int16_t h, bool invert = false, bool mirror_y = false, bool pgm = false);
+    void refresh4G(int16_t x, int16_t y, int16_t w, int16_t h); // screen refresh with grey level waveform
     void powerOff();
   private:
     void _writeScreenBuffer(uint8_t value);
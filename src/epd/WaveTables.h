@@ -105,6 +105,60 @@ const uint8_t GxGDEW027W3_lut_24_bb[] PROGMEM =
 0x00  ,0x00 ,0x00 ,0x00 ,0x00 ,0x00,
 };
 
+// differential partial update LUT for GxEPD2_270::refreshFast(), old data 0x14, new data 0x15
+// only bw (black to white) and wb (white to black) are driven, 25 frames
+const uint8_t GxGDEW027W3_lut_20_vcomDC_partial[] PROGMEM =
+{
+0x00  ,0x00 ,
+0x00  ,0x19 ,0x01 ,0x00 ,0x00 ,0x01,
+0x00  ,0x00 ,0x00 ,0x00 ,0x00 ,0x00,
+0x00  ,0x00 ,0x00 ,0x00 ,0x00 ,0x00,
+0x00  ,0x00 ,0x00 ,0x00 ,0x00 ,0x00,
+0x00  ,0x00 ,0x00 ,0x00 ,0x00 ,0x00,
+0x00  ,0x00 ,0x00 ,0x00 ,0x00 ,0x00,
+0x00  ,0x00 ,0x00 ,0x00 ,0x00 ,0x00,
+};
+const uint8_t GxGDEW027W3_lut_21_ww_partial[] PROGMEM =
+{
+0x00  ,0x19 ,0x01 ,0x00 ,0x00 ,0x01,
+0x00  ,0x00 ,0x00 ,0x00 ,0x00 ,0x00,
+0x00  ,0x00 ,0x00 ,0x00 ,0x00 ,0x00,
+0x00  ,0x00 ,0x00 ,0x00 ,0x00 ,0x00,
+0x00  ,0x00 ,0x00 ,0x00 ,0x00 ,0x00,
+0x00  ,0x00 ,0x00 ,0x00 ,0x00 ,0x00,
+0x00  ,0x00 ,0x00 ,0x00 ,0x00 ,0x00,
+};
+const uint8_t GxGDEW027W3_lut_22_bw_partial[] PROGMEM =
+{
+0x80  ,0x19 ,0x01 ,0x00 ,0x00 ,0x01,
+0x00  ,0x00 ,0x00 ,0x00 ,0x00 ,0x00,
+0x00  ,0x00 ,0x00 ,0x00 ,0x00 ,0x00,
+0x00  ,0x00 ,0x00 ,0x00 ,0x00 ,0x00,
+0x00  ,0x00 ,0x00 ,0x00 ,0x00 ,0x00,
+0x00  ,0x00 ,0x00 ,0x00 ,0x00 ,0x00,
+0x00  ,0x00 ,0x00 ,0x00 ,0x00 ,0x00,
+};
+const uint8_t GxGDEW027W3_lut_23_wb_partial[] PROGMEM =
+{
+0x40  ,0x19 ,0x01 ,0x00 ,0x00 ,0x01,
+0x00  ,0x00 ,0x00 ,0x00 ,0x00 ,0x00,
+0x00  ,0x00 ,0x00 ,0x00 ,0x00 ,0x00,
+0x00  ,0x00 ,0x00 ,0x00 ,0x00 ,0x00,
+0x00  ,0x00 ,0x00 ,0x00 ,0x00 ,0x00,
+0x00  ,0x00 ,0x00 ,0x00 ,0x00 ,0x00,
+0x00  ,0x00 ,0x00 ,0x00 ,0x00 ,0x00,
+};
+const uint8_t GxGDEW027W3_lut_24_bb_partial[] PROGMEM =
+{
+0x00  ,0x19 ,0x01 ,0x00 ,0x00 ,0x01,
+0x00  ,0x00 ,0x00 ,0x00 ,0x00 ,0x00,
+0x00  ,0x00 ,0x00 ,0x00 ,0x00 ,0x00,
+0x00  ,0x00 ,0x00 ,0x00 ,0x00 ,0x00,
+0x00  ,0x00 ,0x00 ,0x00 ,0x00 ,0x00,
+0x00  ,0x00 ,0x00 ,0x00 ,0x00 ,0x00,
+0x00  ,0x00 ,0x00 ,0x00 ,0x00 ,0x00,
+};
+
 const uint8_t GxGDEW0154Z04_lut_20_vcom0[] PROGMEM = {  0x0E  , 0x14 , 0x01 , 0x0A , 0x06 , 0x04 , 0x0A , 0x0A , 0x0F , 0x03 , 0x03 , 0x0C , 0x06 , 0x0A , 0x00 };
 const uint8_t GxGDEW0154Z04_lut_21_w[] PROGMEM = {  0x0E  , 0x14 , 0x01 , 0x0A , 0x46 , 0x04 , 0x8A , 0x4A , 0x0F , 0x83 , 0x43 , 0x0C , 0x86 , 0x0A , 0x04 };
 const uint8_t GxGDEW0154Z04_lut_22_b[] PROGMEM = {  0x0E  , 0x14 , 0x01 , 0x8A , 0x06 , 0x04 , 0x8A , 0x4A , 0x0F , 0x83 , 0x43 , 0x0C , 0x06 , 0x4A , 0x04 };
@@ -284,5 +338,63 @@ const unsigned char GxGDEW042T2_lut_24_bb_partial[] PROGMEM =
   0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
 };
 
+// 4 grey levels, old data (0x10) : high bit, new data (0x13) : low bit of grey level
+
+const unsigned char GxGDEW042T2_lut_20_vcom0_4G[] PROGMEM =
+{
+  0x00, 0x0A, 0x00, 0x00, 0x00, 0x01,
+  0x60, 0x14, 0x14, 0x00, 0x00, 0x01,
+  0x00, 0x14, 0x00, 0x00, 0x00, 0x01,
+  0x00, 0x13, 0x0A, 0x01, 0x00, 0x01,
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+  0x00, 0x00,
+};
+
+const unsigned char GxGDEW042T2_lut_21_ww_4G[] PROGMEM =
+{
+  0x40, 0x0A, 0x00, 0x00, 0x00, 0x01,
+  0x90, 0x14, 0x14, 0x00, 0x00, 0x01,
+  0x10, 0x14, 0x0A, 0x00, 0x00, 0x01,
+  0xA0, 0x13, 0x01, 0x00, 0x00, 0x01,
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+};
+
+const unsigned char GxGDEW042T2_lut_22_bw_4G[] PROGMEM =
+{
+  0x40, 0x0A, 0x00, 0x00, 0x00, 0x01,
+  0x90, 0x14, 0x14, 0x00, 0x00, 0x01,
+  0x00, 0x14, 0x0A, 0x00, 0x00, 0x01,
+  0x99, 0x0C, 0x01, 0x03, 0x04, 0x01,
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+};
+
+const unsigned char GxGDEW042T2_lut_23_wb_4G[] PROGMEM =
+{
+  0x40, 0x0A, 0x00, 0x00, 0x00, 0x01,
+  0x90, 0x14, 0x14, 0x00, 0x00, 0x01,
+  0x00, 0x14, 0x0A, 0x00, 0x00, 0x01,
+  0x99, 0x0B, 0x04, 0x04, 0x01, 0x01,
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+};
+
+const unsigned char GxGDEW042T2_lut_24_bb_4G[] PROGMEM =
+{
+  0x80, 0x0A, 0x00, 0x00, 0x00, 0x01,
+  0x90, 0x14, 0x14, 0x00, 0x00, 0x01,
+  0x20, 0x14, 0x0A, 0x00, 0x00, 0x01,
+  0x50, 0x13, 0x01, 0x00, 0x00, 0x01,
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+};
+
 #endif
 
@@ -12,6 +12,8 @@
 #include "GxEPD2_154c.h"
 #include "WaveTables.h"
 
+static const GxEPD2_EPD::LutRegister GxEPD2_154c_lut_registers[] = {{0x20, 15}, {0x21, 15}, {0x22, 15}, {0x23, 15}, {0x24, 15}, {0x25, 15}, {0x26, 15}, {0x27, 15}};
+
 const uint8_t GxEPD2_154c::bw2grey[] =
 {
   0b00000000, 0b00000011, 0b00001100, 0b00001111,
@@ -23,6 +25,7 @@ const uint8_t GxEPD2_154c::bw2grey[] =
 GxEPD2_154c::GxEPD2_154c(int8_t cs, int8_t dc, int8_t rst, int8_t busy) :
   GxEPD2_EPD(cs, dc, rst, busy, LOW, 20000000, WIDTH, HEIGHT, panel, hasColor, hasPartialUpdate, hasFastPartialUpdate)
 {
+  _setLutRegisters(GxEPD2_154c_lut_registers, 8);
   _initial = true;
   _power_is_on = false;
   _paged = false;
@@ -232,6 +235,11 @@ void GxEPD2_154c::refresh(int16_t x, int16_t y, int16_t w, int16_t h)
   _Update_Full();
 }
 
+void GxEPD2_154c::drawImageBlackOnly(const uint8_t* black, const uint8_t* color, int16_t x, int16_t y, int16_t w, int16_t h, bool invert, bool mirror_y, bool pgm)
+{
+  drawImage(black, color, x, y, w, h, invert, mirror_y, pgm); // no B/W only waveform
+}
+
 void GxEPD2_154c::powerOff()
 {
   _PowerOff();
@@ -285,6 +293,7 @@ void GxEPD2_154c::_InitDisplay()
     delay(10);
     digitalWrite(_rst, 1);
     delay(10);
+    _resident_lut = 0; // LUT registers reset
   }
   _writeCommand(0x01);
   _writeData(0x07);
@@ -313,6 +322,19 @@ void GxEPD2_154c::_InitDisplay()
 void GxEPD2_154c::_Init_Full()
 {
   _InitDisplay();
+  _writeLut(false);
+  _PowerOn();
+}
+
+void GxEPD2_154c::_Init_Part()
+{
+  _InitDisplay();
+  _PowerOn();
+}
+
+void GxEPD2_154c::_writeLut(bool partial_refresh)
+{
+  if (!_updateLut(partial_refresh)) return; // custom LUT uploaded, or resident
   _writeCommand(0x20);
   _writeDataPGM(GxGDEW0154Z04_lut_20_vcom0, sizeof(GxGDEW0154Z04_lut_20_vcom0));
   _writeCommand(0x21);
@@ -329,17 +351,11 @@ void GxEPD2_154c::_Init_Full()
   _writeDataPGM(GxGDEW0154Z04_lut_26_red0, sizeof(GxGDEW0154Z04_lut_26_red0));
   _writeCommand(0x27);
   _writeDataPGM(GxGDEW0154Z04_lut_27_red1, sizeof(GxGDEW0154Z04_lut_27_red1));
-  _PowerOn();
-}
-
-void GxEPD2_154c::_Init_Part()
-{
-  _InitDisplay();
-  _PowerOn();
 }
 
 void GxEPD2_154c::_Update_Full()
 {
+  _writeLut(false);
   _writeCommand(0x12); //display refresh
   _waitWhileBusy("_Update_Full", full_refresh_time);
 }
@@ -155,6 +155,55 @@ void GxEPD2_213c::writeImage(const uint8_t* black, const uint8_t* color, int16_t
   delay(1); // yield() to avoid WDT on ESP8266 and ESP32
 }
 
+void GxEPD2_213c::_writeImage(uint8_t command, const uint8_t* bitmap, int16_t x, int16_t y, int16_t w, int16_t h, bool invert, bool mirror_y, bool pgm)
+{
+  delay(1); // yield() to avoid WDT on ESP8266 and ESP32
+  int16_t wb = (w + 7) / 8; // width bytes, bitmaps are padded
+  x -= x % 8; // byte boundary
+  w = wb * 8; // byte boundary
+  int16_t x1 = x < 0 ? 0 : x; // limit
+  int16_t y1 = y < 0 ? 0 : y; // limit
+  int16_t w1 = x + w < int16_t(WIDTH) ? w : int16_t(WIDTH) - x; // limit
+  int16_t h1 = y + h < int16_t(HEIGHT) ? h : int16_t(HEIGHT) - y; // limit
+  int16_t dx = x1 - x;
+  int16_t dy = y1 - y;
+  w1 -= dx;
+  h1 -= dy;
+  if ((w1 <= 0) || (h1 <= 0)) return;
+  _Init_Part();
+  _writeCommand(0x91); // partial in
+  _setPartialRamArea(x1, y1, w1, h1);
+  _writeCommand(command);
+  for (int16_t i = 0; i < h1; i++)
+  {
+    for (int16_t j = 0; j < w1 / 8; j++)
+    {
+      uint8_t data = 0xFF;
+      if (bitmap)
+      {
+        // use wb, h of bitmap for index!
+        int16_t idx = mirror_y ? j + dx / 8 + ((h - 1 - (i + dy))) * wb : j + dx / 8 + (i + dy) * wb;
+        if (pgm)
+        {
+#if defined(__AVR) || defined(ESP8266) || defined(ESP32)
+          data = pgm_read_byte(&bitmap[idx]);
+#else
+          data = bitmap[idx];
+#endif
+        }
+        else
+        {
+          data = bitmap[idx];
+        }
+        if (invert) data = ~data;
+      }
+      _writeData(data);
+    }
+  }
+  _writeCommand(0x92); // partial out
+  delay(1); // yield() to avoid WDT on ESP8266 and ESP32
+}
+
 void GxEPD2_213c::writeNative(const uint8_t* data1, const uint8_t* data2, int16_t x, int16_t y, int16_t w, int16_t h, bool invert, bool mirror_y, bool pgm)
 {
   if (data1)
@@ -202,11 +251,52 @@ void GxEPD2_213c::refresh(int16_t x, int16_t y, int16_t w, int16_t h)
   _Update_Part();
 }
 
+void GxEPD2_213c::drawImageBlackOnly(const uint8_t* black, const uint8_t* color, int16_t x, int16_t y, int16_t w, int16_t h, bool invert, bool mirror_y, bool pgm)
+{
+  // 0x10 still has the black data of the last refresh, used as old data of the differential waveform
+  _writeImage(0x13, black, x, y, w, h, invert, mirror_y, pgm);
+  _refreshBlackOnly(x, y, w, h);
+  writeImage(black, color, x, y, w, h, invert, mirror_y, pgm); // back to black and color
+}
+
 void GxEPD2_213c::powerOff()
 {
   _PowerOff();
 }
 
+void GxEPD2_213c::_refreshBlackOnly(int16_t x, int16_t y, int16_t w, int16_t h)
+{
+  w += x % 8; // byte boundary
+  x -= x % 8; // byte boundary
+  int16_t x1 = x < 0 ? 0 : x; // limit
+  int16_t y1 = y < 0 ? 0 : y; // limit
+  int16_t w1 = x + w < int16_t(WIDTH) ? w : int16_t(WIDTH) - x; // limit
+  int16_t h1 = y + h < int16_t(HEIGHT) ? h : int16_t(HEIGHT) - y; // limit
+  w1 -= x1 - x;
+  h1 -= y1 - y;
+  _Init_Part();
+  _writeCommand(0x00);
+  _writeData(0xbf); // B/W mode, LUT set by register; _InitDisplay() restores B/W/R mode
+  _writeCommand(0x50);
+  _writeData(0x97); // VCOM and data interval setting for B/W mode
+  // differential B/W waveform, ww and bb not driven; red pixels are white in old and new data, so they are left unchanged
+  _writeCommand(0x20);
+  _writeDataPGM(GxGDEW042T2_lut_20_vcom0_partial, sizeof(GxGDEW042T2_lut_20_vcom0_partial));
+  _writeCommand(0x21);
+  _writeDataPGM(GxGDEW042T2_lut_ww_bb_undriven, sizeof(GxGDEW042T2_lut_ww_bb_undriven));
+  _writeCommand(0x22);
+  _writeDataPGM(GxGDEW042T2_lut_22_bw_partial, sizeof(GxGDEW042T2_lut_22_bw_partial));
+  _writeCommand(0x23);
+  _writeDataPGM(GxGDEW042T2_lut_23_wb_partial, sizeof(GxGDEW042T2_lut_23_wb_partial));
+  _writeCommand(0x24);
+  _writeDataPGM(GxGDEW042T2_lut_ww_bb_undriven, sizeof(GxGDEW042T2_lut_ww_bb_undriven));
+  _writeCommand(0x91); // partial in
+  _setPartialRamArea(x1, y1, w1, h1);
+  _writeCommand(0x12); //display refresh
+  _waitWhileBusy("_refreshBlackOnly", black_only_refresh_time);
+  _writeCommand(0x92); // partial out
+}
+
 void GxEPD2_213c::_setPartialRamArea(uint16_t x, uint16_t y, uint16_t w, uint16_t h)
 {
   uint16_t xe = (x + w - 1) | 0x0007; // byte boundary inclusive (last byte)
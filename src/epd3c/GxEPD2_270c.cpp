@@ -12,9 +12,12 @@
 #include "GxEPD2_270c.h"
 #include "WaveTables.h"
 
+static const GxEPD2_EPD::LutRegister GxEPD2_270c_lut_registers[] = {{0x20, 44}, {0x21, 42}, {0x22, 42}, {0x23, 42}, {0x24, 42}};
+
 GxEPD2_270c::GxEPD2_270c(int8_t cs, int8_t dc, int8_t rst, int8_t busy) :
   GxEPD2_EPD(cs, dc, rst, busy, LOW, 20000000, WIDTH, HEIGHT, panel, hasColor, hasPartialUpdate, hasFastPartialUpdate)
 {
+  _setLutRegisters(GxEPD2_270c_lut_registers, 5);
   _initial = true;
   _power_is_on = false;
 }
@@ -202,6 +205,11 @@ void GxEPD2_270c::refresh(int16_t x, int16_t y, int16_t w, int16_t h)
   _waitWhileBusy("refresh", partial_refresh_time);
 }
 
+void GxEPD2_270c::drawImageBlackOnly(const uint8_t* black, const uint8_t* color, int16_t x, int16_t y, int16_t w, int16_t h, bool invert, bool mirror_y, bool pgm)
+{
+  drawImage(black, color, x, y, w, h, invert, mirror_y, pgm); // no B/W only waveform
+}
+
 void GxEPD2_270c::powerOff()
 {
   _PowerOff();
@@ -219,6 +227,18 @@ void GxEPD2_270c::_writeData_nCS(const uint8_t* data, uint16_t n)
   SPI.endTransaction();
 }
 
+void GxEPD2_270c::_writeLutData(const uint8_t* data, uint16_t n, bool pgm)
+{
+  if (pgm) _writeData_nCS(data, n);
+  else
+  {
+    for (uint16_t i = 0; i < n; i++)
+    {
+      _writeData(data[i]);
+    }
+  }
+}
+
 void GxEPD2_270c::_setPartialRamArea_270c(uint8_t cmd, uint16_t x, uint16_t y, uint16_t w, uint16_t h)
 {
   w = (w + 7 + (x % 8)) & 0xfff8; // byte boundary exclusive (round up)
@@ -259,6 +279,7 @@ void GxEPD2_270c::_InitDisplay()
     delay(10);
     digitalWrite(_rst, 1);
     delay(10);
+    _resident_lut = 0; // LUT registers reset
   }
   _writeCommand(0x01);
   _writeData (0x03);
@@ -307,22 +328,21 @@ void GxEPD2_270c::_InitDisplay()
 void GxEPD2_270c::_Init_Full()
 {
   _InitDisplay();
-  _writeCommand(0x20); //vcom
-  _writeData_nCS(GxGDEW027C44_lut_20_vcomDC, sizeof(GxGDEW027C44_lut_20_vcomDC));
-  _writeCommand(0x21); //ww --
-  _writeData_nCS(GxGDEW027C44_lut_21, sizeof(GxGDEW027C44_lut_21));
-  _writeCommand(0x22); //bw r
-  _writeData_nCS(GxGDEW027C44_lut_22_red, sizeof(GxGDEW027C44_lut_22_red));
-  _writeCommand(0x23); //wb w
-  _writeData_nCS(GxGDEW027C44_lut_23_white, sizeof(GxGDEW027C44_lut_23_white));
-  _writeCommand(0x24); //bb b
-  _writeData_nCS(GxGDEW027C44_lut_24_black, sizeof(GxGDEW027C44_lut_24_black));
+  _writeLut(false);
   _PowerOn();
 }
 
 void GxEPD2_270c::_Init_Part()
 {
   _InitDisplay();
+  _writeLut(true);
+  _PowerOn();
+}
+
+void GxEPD2_270c::_writeLut(bool partial_refresh)
+{
+  if (!_updateLut(partial_refresh)) return; // custom LUT uploaded, or resident
+  // no partial update LUT
   _writeCommand(0x20); //vcom
   _writeData_nCS(GxGDEW027C44_lut_20_vcomDC, sizeof(GxGDEW027C44_lut_20_vcomDC));
   _writeCommand(0x21); //ww --
@@ -333,17 +353,18 @@ void GxEPD2_270c::_Init_Part()
   _writeData_nCS(GxGDEW027C44_lut_23_white, sizeof(GxGDEW027C44_lut_23_white));
   _writeCommand(0x24); //bb b
   _writeData_nCS(GxGDEW027C44_lut_24_black, sizeof(GxGDEW027C44_lut_24_black));
-  _PowerOn();
 }
 
 void GxEPD2_270c::_Update_Full()
 {
+  _writeLut(false);
   _writeCommand(0x12); //display refresh
   _waitWhileBusy("_Update_Full", full_refresh_time);
 }
 
 void GxEPD2_270c::_Update_Part()
 {
+  _writeLut(true);
   _writeCommand(0x12); //display refresh
   _waitWhileBusy("_Update_Part", partial_refresh_time);
 }
@@ -28,6 +28,8 @@ class GxEPD2_290c : public GxEPD2_EPD
     static const uint16_t power_off_time = 30; // ms, e.g. 20291us
     static const uint16_t full_refresh_time = 15000; // ms, e.g. 14845408us
     static const uint16_t partial_refresh_time = 15000; // ms, e.g. 14845408us
+    static const bool hasBlackOnlyRefresh = true;
+    static const uint16_t black_only_refresh_time = 1500; // ms, estimate, B/W differential waveform
     // constructor
     GxEPD2_290c(int8_t cs, int8_t dc, int8_t rst, int8_t busy);
     // methods (virtual)
@@ -49,9 +51,15 @@ class GxEPD2_290c : public GxEPD2_EPD
     void drawNative(const uint8_t* data1, const uint8_t* data2, int16_t x, int16_t y, int16_t w, int16_t h, bool invert = false, bool mirror_y = false, bool pgm = false);
     void refresh(bool partial_update_mode = false); // screen refresh from controller memory to full screen
     void refresh(int16_t x, int16_t y, int16_t w, int16_t h); // screen refresh from controller memory, partial screen
+    // write black to controller memory and refresh with a B/W only waveform, red is left unchanged;
+    // the color plane must be unchanged since the last refresh, controller memory is restored to black and color
+    // falls back to drawImage(black, color, ...) if !hasBlackOnlyRefresh
+    void drawImageBlackOnly(const uint8_t* black, const uint8_t* color, int16_t x, int16_t y, int16_t w, int16_t h, bool invert = false, bool mirror_y = false, bool pgm = false);
     void powerOff();
   private:
     void _writeScreenBuffer(uint8_t value);
+    void _writeImage(uint8_t command, const uint8_t* bitmap, int16_t x, int16_t y, int16_t w, int16_t h, bool invert, bool mirror_y, bool pgm);
+    void _refreshBlackOnly(int16_t x, int16_t y, int16_t w, int16_t h);
     void _setPartialRamArea(uint16_t x, uint16_t y, uint16_t w, uint16_t h);
     void _PowerOn();
     void _PowerOff();
@@ -243,6 +243,11 @@ void GxEPD2_750c::refresh(int16_t x, int16_t y, int16_t w, int16_t h)
   _Update_Part();
 }
 
+void GxEPD2_750c::drawImageBlackOnly(const uint8_t* black, const uint8_t* color, int16_t x, int16_t y, int16_t w, int16_t h, bool invert, bool mirror_y, bool pgm)
+{
+  drawImage(black, color, x, y, w, h, invert, mirror_y, pgm); // no B/W only waveform
+}
+
 void GxEPD2_750c::powerOff()
 {
   _PowerOff();
@@ -284,5 +284,18 @@ const unsigned char GxGDEW042T2_lut_24_bb_partial[] PROGMEM =
   0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
 };
 
+// ww and bb for the B/W only refresh of 3-color panels: unchanged pixels, red ones included, stay at GND
+const unsigned char GxGDEW042T2_lut_ww_bb_undriven[] PROGMEM =
+{
+  0x00, // 00 00 00 00
+  TP0A, TP0B, 0x01, 0x00, 0x01,
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+};
+
 #endif
 